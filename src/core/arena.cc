@@ -0,0 +1,167 @@
+#include "core/precompiled.hh"
+#include "core/arena.hh"
+
+#include "core/config.hh"
+#include "core/constexpr.hh"
+
+// Heap blocks a thread spills into once
+// its arena is full; freed on rewind
+struct OverflowBlock final {
+    OverflowBlock *next;
+    std::size_t size;
+};
+
+struct FrameArena final {
+    std::byte *data;
+    std::size_t size;
+    std::size_t position;
+    std::size_t overflow_bytes;
+    OverflowBlock *overflow;
+    std::uint64_t frame;
+};
+
+constexpr static std::size_t DEFAULT_ARENA_SIZE = 1048576;
+
+// Size of each thread's arena; changes only
+// affect threads that haven't allocated yet
+static ConfigHandle<std::size_t> arena_size;
+
+static std::atomic<std::uint64_t> current_frame = 1;
+static std::atomic<std::size_t> frame_used_bytes = 0;
+static std::atomic<std::size_t> frame_overflow_bytes = 0;
+static std::atomic<std::size_t> last_used_bytes = 0;
+static std::atomic<std::size_t> last_overflow_bytes = 0;
+static std::atomic<std::size_t> high_water = 0;
+
+// Thread-local destructors free the storage
+// once a thread that used its arena exits
+struct ThreadArena final {
+    FrameArena arena = {};
+    ~ThreadArena(void);
+};
+
+thread_local static ThreadArena local_arena;
+
+static void free_overflow(FrameArena &arena)
+{
+    while(arena.overflow) {
+        auto next = arena.overflow->next;
+        std::free(arena.overflow);
+        arena.overflow = next;
+    }
+
+    arena.overflow_bytes = 0;
+}
+
+static void atomic_max(std::atomic<std::size_t> &target, std::size_t value)
+{
+    std::size_t previous = target.load(std::memory_order_relaxed);
+    while((value > previous) && !target.compare_exchange_weak(previous, value, std::memory_order_relaxed));
+}
+
+static void rewind(FrameArena &arena, std::uint64_t frame)
+{
+    const std::size_t used_bytes = arena.position + arena.overflow_bytes;
+
+    if(used_bytes) {
+        atomic_max(high_water, used_bytes);
+
+        // Usage is attributed to the frame the arena
+        // was last rewound at; if that was a while ago the
+        // numbers are stale and aren't worth reporting
+        if(arena.frame + 1 == frame) {
+            atomic_max(frame_used_bytes, used_bytes);
+            frame_overflow_bytes.fetch_add(arena.overflow_bytes, std::memory_order_relaxed);
+        }
+    }
+
+    free_overflow(arena);
+
+    arena.position = 0;
+    arena.frame = frame;
+}
+
+static FrameArena &get_local_arena(void)
+{
+    auto &arena = local_arena.arena;
+    const std::uint64_t frame = current_frame.load(std::memory_order_acquire);
+
+    if(arena.data == nullptr) {
+        arena.size = arena_size.cell ? config::get(arena_size) : DEFAULT_ARENA_SIZE;
+        arena.data = static_cast<std::byte *>(std::malloc(arena.size));
+        arena.size = arena.data ? arena.size : 0;
+        arena.position = 0;
+        arena.overflow_bytes = 0;
+        arena.overflow = nullptr;
+        arena.frame = frame;
+    }
+    else if(arena.frame != frame) {
+        rewind(arena, frame);
+    }
+
+    return arena;
+}
+
+ThreadArena::~ThreadArena(void)
+{
+    free_overflow(arena);
+    std::free(arena.data);
+}
+
+void frame_arena::init(void)
+{
+    arena_size = config::add<std::size_t>("frame_arena.size", DEFAULT_ARENA_SIZE);
+}
+
+void frame_arena::next_frame(void)
+{
+    // The main thread rewinds eagerly so that its
+    // usage shows up in this frame's statistics
+    auto &arena = get_local_arena();
+    const std::uint64_t frame = current_frame.fetch_add(1, std::memory_order_acq_rel) + 1;
+    rewind(arena, frame);
+
+    last_used_bytes.store(frame_used_bytes.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+    last_overflow_bytes.store(frame_overflow_bytes.exchange(0, std::memory_order_relaxed), std::memory_order_relaxed);
+}
+
+void *frame_arena::allocate(std::size_t size, std::size_t alignment)
+{
+    auto &arena = get_local_arena();
+
+    // std::malloc only guarantees fundamental alignment for
+    // the arena itself so the address is aligned, not the offset
+    const auto current = reinterpret_cast<std::uintptr_t>(arena.data) + arena.position;
+    const auto padding = ((current + alignment - 1) & ~static_cast<std::uintptr_t>(alignment - 1)) - current;
+    const std::size_t aligned = arena.position + static_cast<std::size_t>(padding);
+
+    if((aligned <= arena.size) && (size <= arena.size - aligned)) {
+        arena.position = aligned + size;
+        return arena.data + aligned;
+    }
+
+    // The arena is full; spill into the heap
+    const std::size_t header_size = cxpr::max(sizeof(OverflowBlock), alignment);
+    auto block = static_cast<OverflowBlock *>(std::malloc(header_size + size + alignment));
+
+    if(block == nullptr)
+        throw std::bad_alloc();
+
+    block->next = arena.overflow;
+    block->size = size;
+    arena.overflow = block;
+    arena.overflow_bytes += size;
+
+    const auto address = reinterpret_cast<std::uintptr_t>(block) + header_size;
+    return reinterpret_cast<void *>((address + alignment - 1) & ~static_cast<std::uintptr_t>(alignment - 1));
+}
+
+FrameArenaStats frame_arena::get_stats(void)
+{
+    FrameArenaStats result;
+    result.capacity = arena_size.cell ? config::get(arena_size) : DEFAULT_ARENA_SIZE;
+    result.used_bytes = last_used_bytes.load(std::memory_order_relaxed);
+    result.high_water = high_water.load(std::memory_order_relaxed);
+    result.overflow_bytes = last_overflow_bytes.load(std::memory_order_relaxed);
+    return result;
+}
@@ -0,0 +1,110 @@
+#ifndef CORE_ARENA_HH
+#define CORE_ARENA_HH 1
+#pragma once
+
+/**
+ * Frame arena usage counters
+ */
+struct FrameArenaStats final {
+    std::size_t capacity;       ///< Size of each thread's arena
+    std::size_t used_bytes;     ///< Most bytes a thread used during the last frame
+    std::size_t high_water;     ///< Most bytes a thread ever used during a frame
+    std::size_t overflow_bytes; ///< Bytes that didn't fit and went to the heap during the last frame
+};
+
+namespace frame_arena
+{
+/**
+ * Registers frame arena config variables
+ */
+void init(void);
+
+/**
+ * Starts a new frame; every thread's arena is
+ * rewound the next time that thread allocates from it
+ * @note Should be called once per frame from the main thread
+ * @warning Memory handed out during the previous
+ * frame must not be used after this is called
+ */
+void next_frame(void);
+} // namespace frame_arena
+
+namespace frame_arena
+{
+/**
+ * Bump-allocates memory that lives until the end of the
+ * frame from the calling thread's arena; a full arena
+ * spills into heap blocks that are freed on rewind
+ * @param size Amount of bytes
+ * @param alignment Alignment, must be a power of two
+ * @returns Allocated memory, never nullptr
+ */
+void *allocate(std::size_t size, std::size_t alignment);
+
+/**
+ * Get arena usage counters
+ * @returns Counters aggregated over all threads
+ */
+FrameArenaStats get_stats(void);
+} // namespace frame_arena
+
+/**
+ * A standard library allocator that takes memory from
+ * the calling thread's frame arena; deallocation is a no-op
+ * @warning Containers using this must not outlive the frame
+ */
+template<typename T>
+struct FrameAllocator {
+    using value_type = T;
+
+    FrameAllocator(void) noexcept = default;
+
+    template<typename U>
+    FrameAllocator(const FrameAllocator<U> &other) noexcept;
+
+    T *allocate(std::size_t count);
+    void deallocate(T *pointer, std::size_t count) noexcept;
+};
+
+template<typename T, typename U>
+constexpr static inline bool operator==(const FrameAllocator<T> &a, const FrameAllocator<U> &b);
+
+template<typename T, typename U>
+constexpr static inline bool operator!=(const FrameAllocator<T> &a, const FrameAllocator<U> &b);
+
+template<typename T>
+using FrameVector = std::vector<T, FrameAllocator<T>>;
+using FrameString = std::basic_string<char, std::char_traits<char>, FrameAllocator<char>>;
+
+template<typename T>
+template<typename U>
+inline FrameAllocator<T>::FrameAllocator(const FrameAllocator<U> &) noexcept
+{
+
+}
+
+template<typename T>
+inline T *FrameAllocator<T>::allocate(std::size_t count)
+{
+    return static_cast<T *>(frame_arena::allocate(count * sizeof(T), alignof(T)));
+}
+
+template<typename T>
+inline void FrameAllocator<T>::deallocate(T *, std::size_t) noexcept
+{
+
+}
+
+template<typename T, typename U>
+constexpr static inline bool operator==(const FrameAllocator<T> &, const FrameAllocator<U> &)
+{
+    return true;
+}
+
+template<typename T, typename U>
+constexpr static inline bool operator!=(const FrameAllocator<T> &, const FrameAllocator<U> &)
+{
+    return false;
+}
+
+#endif /* CORE_ARENA_HH */
@@ -0,0 +1,235 @@
+#include "core/precompiled.hh"
+#include "core/bitstream.hh"
+
+#include "core/assert.hh"
+#include "core/byteorder.hh"
+#include "core/constexpr.hh"
+
+constexpr static float TWO_PI = static_cast<float>(2.0 * M_PI);
+
+static inline std::uint64_t bit_mask(unsigned int bits)
+{
+    return (UINT64_C(1) << bits) - UINT64_C(1);
+}
+
+static inline std::uint32_t quantize(float value, float min, float max, unsigned int bits)
+{
+    // An empty range only has one value to
+    // encode and would divide by zero below
+    if(max == min)
+        return 0U;
+
+    const float ratio = (value - min) / (max - min);
+
+    // cxpr::clamp lets NaN through and
+    // std::llround has no result for it
+    if(std::isnan(ratio))
+        return 0U;
+
+    const float alpha = cxpr::clamp(ratio, 0.0f, 1.0f);
+    return static_cast<std::uint32_t>(std::llround(static_cast<double>(alpha) * static_cast<double>(bit_mask(bits))));
+}
+
+static inline float dequantize(std::uint32_t value, float min, float max, unsigned int bits)
+{
+    const double alpha = static_cast<double>(value) / static_cast<double>(bit_mask(bits));
+    return static_cast<float>(static_cast<double>(min) + static_cast<double>(max - min) * alpha);
+}
+
+void BitWriter::write_bits(BitWriter &writer, std::uint32_t value, unsigned int bits)
+{
+    QF_assert_debug((bits >= 1U) && (bits <= 32U));
+
+    // The scratch word never holds 32 or more bits between
+    // calls, so appending up to 32 more bits never overflows it
+    writer.scratch = (writer.scratch << bits) | (value & bit_mask(bits));
+    writer.scratch_bits += bits;
+
+    if(writer.scratch_bits >= 32U) {
+        writer.scratch_bits -= 32U;
+
+        const auto position = writer.vector.size();
+        writer.vector.resize(position + sizeof(std::uint32_t));
+        byteorder::store_big<std::uint32_t>(writer.vector.data() + position, static_cast<std::uint32_t>(writer.scratch >> writer.scratch_bits));
+
+        writer.scratch &= bit_mask(writer.scratch_bits);
+    }
+}
+
+void BitWriter::write_signed(BitWriter &writer, std::int32_t value, unsigned int bits)
+{
+    BitWriter::write_bits(writer, static_cast<std::uint32_t>(value), bits);
+}
+
+void BitWriter::write_bool(BitWriter &writer, bool value)
+{
+    BitWriter::write_bits(writer, value ? 1U : 0U, 1U);
+}
+
+void BitWriter::write_quantized(BitWriter &writer, float value, float min, float max, unsigned int bits)
+{
+    BitWriter::write_bits(writer, quantize(value, min, max, bits), bits);
+}
+
+void BitWriter::write_angle(BitWriter &writer, float value, unsigned int bits)
+{
+    float wrapped = std::fmod(value, TWO_PI);
+    if(wrapped < 0.0f)
+        wrapped += TWO_PI;
+    if(!std::isfinite(wrapped))
+        wrapped = 0.0f;
+
+    // The full turn wraps around to zero so the
+    // topmost quantized value is never actually used
+    auto quantized = static_cast<std::uint64_t>(std::llround(static_cast<double>(wrapped / TWO_PI) * static_cast<double>(bit_mask(bits) + 1U)));
+    BitWriter::write_bits(writer, static_cast<std::uint32_t>(quantized & bit_mask(bits)), bits);
+}
+
+void BitWriter::write_unit_vector(BitWriter &writer, const glm::fvec3 &value, unsigned int bits)
+{
+    const float length = cxpr::abs(value.x) + cxpr::abs(value.y) + cxpr::abs(value.z);
+
+    float x = 0.0f;
+    float y = 0.0f;
+
+    if(length > 0.0f) {
+        x = value.x / length;
+        y = value.y / length;
+
+        if(value.z < 0.0f) {
+            // Fold the lower hemisphere over the diagonals
+            const float fx = (1.0f - cxpr::abs(y)) * ((x >= 0.0f) ? 1.0f : -1.0f);
+            const float fy = (1.0f - cxpr::abs(x)) * ((y >= 0.0f) ? 1.0f : -1.0f);
+            x = fx;
+            y = fy;
+        }
+    }
+
+    BitWriter::write_quantized(writer, x, -1.0f, 1.0f, bits);
+    BitWriter::write_quantized(writer, y, -1.0f, 1.0f, bits);
+}
+
+void BitWriter::flush(BitWriter &writer)
+{
+    if(writer.scratch_bits) {
+        const unsigned int nbytes = (writer.scratch_bits + 7U) / 8U;
+        const std::uint64_t padded = writer.scratch << (nbytes * 8U - writer.scratch_bits);
+
+        for(unsigned int i = nbytes; i > 0U; --i) {
+            writer.vector.push_back(static_cast<std::byte>((padded >> ((i - 1U) * 8U)) & 0xFFU));
+        }
+    }
+
+    writer.scratch = UINT64_C(0);
+    writer.scratch_bits = 0U;
+}
+
+std::size_t BitWriter::bit_size(const BitWriter &writer)
+{
+    return writer.vector.size() * 8U + writer.scratch_bits;
+}
+
+void BitWriter::setup(BitWriter &writer, std::size_t size_hint)
+{
+    writer.scratch = UINT64_C(0);
+    writer.scratch_bits = 0U;
+    writer.vector.clear();
+    writer.vector.reserve(size_hint);
+}
+
+std::uint32_t BitReader::read_bits(BitReader &reader, unsigned int bits)
+{
+    QF_assert_debug((bits >= 1U) && (bits <= 32U));
+
+    if(reader.scratch_bits < bits) {
+        // Refill with a whole word whenever possible; the scratch
+        // word holds less than 32 bits here so it never overflows
+        if((reader.read_position + sizeof(std::uint32_t)) <= reader.size) {
+            reader.scratch = (reader.scratch << 32U) | byteorder::load_big<std::uint32_t>(reader.data + reader.read_position);
+            reader.read_position += sizeof(std::uint32_t);
+        }
+        else {
+            for(unsigned int i = 0U; i < sizeof(std::uint32_t); ++i) {
+                std::uint64_t byte = UINT64_C(0);
+                if(reader.read_position < reader.size)
+                    byte = static_cast<std::uint64_t>(reader.data[reader.read_position]);
+                reader.scratch = (reader.scratch << 8U) | byte;
+                reader.read_position += 1U;
+            }
+        }
+
+        reader.scratch_bits += 32U;
+    }
+
+    reader.scratch_bits -= bits;
+    reader.bit_position += bits;
+
+    auto result = static_cast<std::uint32_t>((reader.scratch >> reader.scratch_bits) & bit_mask(bits));
+    reader.scratch &= bit_mask(reader.scratch_bits);
+    return result;
+}
+
+std::int32_t BitReader::read_signed(BitReader &reader, unsigned int bits)
+{
+    const std::uint32_t value = BitReader::read_bits(reader, bits);
+    const std::uint32_t sign = UINT32_C(1) << (bits - 1U);
+    return static_cast<std::int32_t>((value ^ sign) - sign);
+}
+
+bool BitReader::read_bool(BitReader &reader)
+{
+    return BitReader::read_bits(reader, 1U) != 0U;
+}
+
+float BitReader::read_quantized(BitReader &reader, float min, float max, unsigned int bits)
+{
+    return dequantize(BitReader::read_bits(reader, bits), min, max, bits);
+}
+
+float BitReader::read_angle(BitReader &reader, unsigned int bits)
+{
+    const double alpha = static_cast<double>(BitReader::read_bits(reader, bits)) / static_cast<double>(bit_mask(bits) + 1U);
+    const float angle = static_cast<float>(alpha * static_cast<double>(TWO_PI));
+
+    // Map back into -PI..+PI range
+    if(angle >= static_cast<float>(M_PI))
+        return angle - TWO_PI;
+    return angle;
+}
+
+glm::fvec3 BitReader::read_unit_vector(BitReader &reader, unsigned int bits)
+{
+    const float x = BitReader::read_quantized(reader, -1.0f, 1.0f, bits);
+    const float y = BitReader::read_quantized(reader, -1.0f, 1.0f, bits);
+    const float z = 1.0f - cxpr::abs(x) - cxpr::abs(y);
+
+    glm::fvec3 result = glm::fvec3(x, y, z);
+
+    if(z < 0.0f) {
+        result.x = (1.0f - cxpr::abs(y)) * ((x >= 0.0f) ? 1.0f : -1.0f);
+        result.y = (1.0f - cxpr::abs(x)) * ((y >= 0.0f) ? 1.0f : -1.0f);
+    }
+
+    return glm::normalize(result);
+}
+
+bool BitReader::overflow(const BitReader &reader)
+{
+    return reader.bit_position > (reader.size * 8U);
+}
+
+void BitReader::setup(BitReader &reader, const void *data, std::size_t size)
+{
+    reader.scratch = UINT64_C(0);
+    reader.scratch_bits = 0U;
+    reader.read_position = 0;
+    reader.bit_position = 0;
+    reader.size = size;
+    reader.data = reinterpret_cast<const std::byte *>(data);
+}
+
+void BitReader::setup(BitReader &reader, const BitWriter &writer)
+{
+    QF_assert_debug(writer.scratch_bits == 0U);
+    BitReader::setup(reader, writer.vector.data(), writer.vector.size());
+}
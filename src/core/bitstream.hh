@@ -0,0 +1,132 @@
+#ifndef CORE_BITSTREAM_HH
+#define CORE_BITSTREAM_HH 1
+#pragma once
+
+/**
+ * A bit-packed companion to RWBuffer; values are
+ * accumulated in a 64-bit scratch word and flushed
+ * into the vector in 32-bit big-endian chunks
+ * @note Bits are stored most significant bit first
+ */
+class BitWriter final {
+public:
+    std::uint64_t scratch;
+    unsigned int scratch_bits;
+    std::vector<std::byte> vector;
+
+public:
+    /**
+     * Writes the lower bits of a value
+     * @param writer The writer
+     * @param value The value
+     * @param bits Amount of bits to write, 1 to 32
+     */
+    static void write_bits(BitWriter &writer, std::uint32_t value, unsigned int bits);
+
+    /**
+     * Writes a two's complement signed value
+     * @param writer The writer
+     * @param value The value; must fit into `bits`
+     * @param bits Amount of bits to write, 1 to 32
+     */
+    static void write_signed(BitWriter &writer, std::int32_t value, unsigned int bits);
+
+    static void write_bool(BitWriter &writer, bool value);
+
+    /**
+     * Writes a float quantized within a fixed range
+     * @param writer The writer
+     * @param value The value; clamped to the range, NaN is written as `min`
+     * @param min Lower range bound
+     * @param max Upper range bound
+     * @param bits Amount of bits to write, 1 to 32
+     */
+    static void write_quantized(BitWriter &writer, float value, float min, float max, unsigned int bits);
+
+    /**
+     * Writes an angle wrapped into a full turn
+     * @param writer The writer
+     * @param value The angle in radians; NaN and infinities are written as zero
+     * @param bits Amount of bits to write, 1 to 32
+     */
+    static void write_angle(BitWriter &writer, float value, unsigned int bits);
+
+    /**
+     * Writes a unit vector using octahedral encoding
+     * @param writer The writer
+     * @param value The vector; doesn't have to be normalized
+     * @param bits Amount of bits per component, two components are written
+     * @see [A Survey of Efficient Representations for Independent Unit Vectors](https://jcgt.org/published/0003/02/01/)
+     */
+    static void write_unit_vector(BitWriter &writer, const glm::fvec3 &value, unsigned int bits);
+
+public:
+    /**
+     * Pads the stream to a byte boundary and moves
+     * whatever is left in the scratch word into the vector
+     * @param writer The writer
+     */
+    static void flush(BitWriter &writer);
+
+    /**
+     * Figure out how many bits were written
+     * @param writer The writer
+     * @returns Amount of bits written, including padding from previous flushes
+     */
+    static std::size_t bit_size(const BitWriter &writer);
+
+    /**
+     * Setup a writer for writing
+     * @param writer The writer
+     * @param size_hint Expected amount of bytes to be written
+     */
+    static void setup(BitWriter &writer, std::size_t size_hint = 0);
+};
+
+/**
+ * A non-owning bit-packed reader; reading
+ * past the end produces zeroes just like
+ * RWBuffer and RWView do
+ */
+class BitReader final {
+public:
+    std::uint64_t scratch;
+    unsigned int scratch_bits;
+    std::size_t read_position;
+    std::size_t bit_position;
+    std::size_t size;
+    const std::byte *data;
+
+public:
+    static std::uint32_t read_bits(BitReader &reader, unsigned int bits);
+    static std::int32_t read_signed(BitReader &reader, unsigned int bits);
+    static bool read_bool(BitReader &reader);
+    static float read_quantized(BitReader &reader, float min, float max, unsigned int bits);
+    static float read_angle(BitReader &reader, unsigned int bits);
+    static glm::fvec3 read_unit_vector(BitReader &reader, unsigned int bits);
+
+public:
+    /**
+     * Checks if the reader went past the end of the data
+     * @param reader The reader
+     * @returns true if any bits were read past the end
+     */
+    static bool overflow(const BitReader &reader);
+
+    /**
+     * Setup a reader for reading
+     * @param reader The reader
+     * @param data The data to read from
+     * @param size The data size in bytes
+     */
+    static void setup(BitReader &reader, const void *data, std::size_t size);
+
+    /**
+     * Setup a reader for reading the contents of a writer
+     * @param reader The reader
+     * @param writer The writer; must be flushed
+     */
+    static void setup(BitReader &reader, const BitWriter &writer);
+};
+
+#endif /* CORE_BITSTREAM_HH */
@@ -0,0 +1,125 @@
+#ifndef CORE_BYTEORDER_HH
+#define CORE_BYTEORDER_HH 1
+#pragma once
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <stdlib.h>
+#define QF_bswap16(x) _byteswap_ushort(x)
+#define QF_bswap32(x) _byteswap_ulong(x)
+#define QF_bswap64(x) _byteswap_uint64(x)
+#else
+#define QF_bswap16(x) __builtin_bswap16(x)
+#define QF_bswap32(x) __builtin_bswap32(x)
+#define QF_bswap64(x) __builtin_bswap64(x)
+#endif
+
+#if defined(__BYTE_ORDER__) && (__BYTE_ORDER__ == __ORDER_BIG_ENDIAN__)
+constexpr static bool QF_BIG_ENDIAN = true;
+#else
+constexpr static bool QF_BIG_ENDIAN = false;
+#endif
+
+namespace byteorder
+{
+/**
+ * Converts a host-order value into big-endian (network) order
+ * @param value Input value
+ * @returns `value` with its bytes in big-endian order
+ * @note Applying this twice yields the original value,
+ * so it's also used to convert from big-endian to host order
+ */
+static inline std::uint16_t big(const std::uint16_t value);
+static inline std::uint32_t big(const std::uint32_t value);
+static inline std::uint64_t big(const std::uint64_t value);
+
+/**
+ * Converts a host-order value into little-endian order
+ * @param value Input value
+ * @returns `value` with its bytes in little-endian order
+ */
+static inline std::uint64_t little(const std::uint64_t value);
+
+/**
+ * Loads a big-endian value from potentially unaligned memory
+ * @param data Memory to load from
+ * @returns Loaded value in host byte order
+ */
+template<typename T>
+static inline T load_big(const void *data);
+
+/**
+ * Stores a value into potentially unaligned memory in big-endian order
+ * @param data Memory to store into
+ * @param value Value in host byte order
+ */
+template<typename T>
+static inline void store_big(void *data, const T value);
+
+/**
+ * Loads a little-endian value from potentially unaligned memory
+ * @param data Memory to load from
+ * @returns Loaded value in host byte order
+ */
+static inline std::uint64_t load_little64(const void *data);
+} // namespace byteorder
+
+static inline std::uint16_t byteorder::big(const std::uint16_t value)
+{
+    if(QF_BIG_ENDIAN)
+        return value;
+    return QF_bswap16(value);
+}
+
+static inline std::uint32_t byteorder::big(const std::uint32_t value)
+{
+    if(QF_BIG_ENDIAN)
+        return value;
+    return QF_bswap32(value);
+}
+
+static inline std::uint64_t byteorder::big(const std::uint64_t value)
+{
+    if(QF_BIG_ENDIAN)
+        return value;
+    return QF_bswap64(value);
+}
+
+static inline std::uint64_t byteorder::little(const std::uint64_t value)
+{
+    if(QF_BIG_ENDIAN)
+        return QF_bswap64(value);
+    return value;
+}
+
+template<typename T>
+static inline T byteorder::load_big(const void *data)
+{
+    static_assert(std::is_unsigned_v<T>);
+    T value;
+    std::memcpy(&value, data, sizeof(T));
+    if constexpr(sizeof(T) == 1)
+        return value;
+    else return byteorder::big(value);
+}
+
+template<typename T>
+static inline void byteorder::store_big(void *data, const T value)
+{
+    static_assert(std::is_unsigned_v<T>);
+    if constexpr(sizeof(T) == 1) {
+        std::memcpy(data, &value, sizeof(T));
+    }
+    else {
+        const T swapped = byteorder::big(value);
+        std::memcpy(data, &swapped, sizeof(T));
+    }
+}
+
+static inline std::uint64_t byteorder::load_little64(const void *data)
+{
+    std::uint64_t value;
+    std::memcpy(&value, data, sizeof(value));
+    return byteorder::little(value);
+}
+
+#endif /* CORE_BYTEORDER_HH */
@@ -2,7 +2,10 @@
 #include "core/config.hh"
 
 #include "core/assert.hh"
+#include "core/constexpr.hh"
 #include "core/logging.hh"
+#include "core/memtrack.hh"
+#include "core/profiler.hh"
 #include "core/strtools.hh"
 
 constexpr static unsigned int CONFIG_INT    = 0;
@@ -17,47 +20,119 @@ struct ConfigValue final {
     unsigned int type;
     std::size_t size;
     void *data_ptr;
+    ConfigCell *cell;
 };
 
-static std::unordered_map<std::string, ConfigValue> vmap;
+// Lets vmap be searched with std::string_view
+// keys without building a temporary std::string
+struct ConfigKeyHash final {
+    using is_transparent = void;
+
+    std::size_t operator()(std::string_view key) const noexcept
+    {
+        return std::hash<std::string_view>()(key);
+    }
+};
+
+static std::unordered_map<std::string, ConfigValue, ConfigKeyHash, std::equal_to<>> vmap;
+
+// Storage for handle-bound values; std::deque
+// never relocates its elements so the handles
+// given out by config::add stay valid
+static std::deque<ConfigCell> cells;
+
+// Loaded files are remembered in the order they
+// were loaded so that they can be re-read when they change
+struct ConfigFile final {
+    std::string filename;
+    std::vector<char> source;
+    std::unordered_map<std::string_view, std::string_view> values;
+    PHYSFS_sint64 modtime;
+    std::string watch_name;
+    int watch_descriptor;
+};
+
+static std::deque<ConfigFile> files;
+static std::unordered_multimap<std::string, QF_ConfigCallback> callbacks;
+static bool watch_enabled = false;
+
+#ifdef __linux__
+static int watch_fd = -1;
+#else
+// Without inotify, modification times are
+// checked with this interval instead
+constexpr static std::chrono::milliseconds WATCH_POLL_INTERVAL = std::chrono::milliseconds(1000);
+static std::chrono::steady_clock::time_point watch_next_poll;
+#endif
 
 static const char *static_asprintf(const char *format, ...)
 {
-    static std::vector<char> buffer;
+    thread_local static std::vector<char> buffer;
 
-    va_list va;
+    va_list va, vb;
     va_start(va, format);
+    va_copy(vb, va);
     buffer.resize(2 + stbsp_vsnprintf(nullptr, 0, format, va));
-    stbsp_vsnprintf(buffer.data(), buffer.size(), format, va);
+    stbsp_vsnprintf(buffer.data(), buffer.size(), format, vb);
+    va_end(vb);
     va_end(va);
 
     return buffer.data();
 }
 
+template<typename T>
+static T load_value(const ConfigValue &value)
+{
+    if(value.cell) {
+        return config::get(ConfigHandle<T>{value.cell});
+    }
+
+    return reinterpret_cast<const T *>(value.data_ptr)[0];
+}
+
+template<typename T>
+static void store_value(ConfigValue &value, T actual_value)
+{
+    if(value.cell) {
+        config::set(ConfigHandle<T>{value.cell}, actual_value);
+        return;
+    }
+
+    reinterpret_cast<T *>(value.data_ptr)[0] = actual_value;
+}
+
+template<typename T>
+static void scan_value(ConfigValue &value, const char *format, const char *string)
+{
+    T actual_value = load_value<T>(value);
+    std::sscanf(string, format, &actual_value);
+    store_value<T>(value, actual_value);
+}
+
 static const char *value_to_string(const ConfigValue &value)
 {
     if(value.type == CONFIG_INT) {
-        auto actual_value = reinterpret_cast<const int *>(value.data_ptr)[0];
+        auto actual_value = load_value<int>(value);
         return static_asprintf("%d", actual_value);
     }
 
     if(value.type == CONFIG_BOOL) {
-        auto actual_value = reinterpret_cast<const bool *>(value.data_ptr)[0];
+        auto actual_value = load_value<bool>(value);
         return actual_value ? "true" : "false";
     }
 
     if(value.type == CONFIG_FLOAT) {
-        auto actual_value = reinterpret_cast<const float *>(value.data_ptr)[0];
+        auto actual_value = load_value<float>(value);
         return static_asprintf("%f", actual_value);
     }
 
     if(value.type == CONFIG_SIZE_T) {
-        auto actual_value = reinterpret_cast<const std::size_t *>(value.data_ptr)[0];
+        auto actual_value = load_value<std::size_t>(value);
         return static_asprintf("%zu", actual_value);
     }
 
     if(value.type == CONFIG_UINT) {
-        auto actual_value = reinterpret_cast<const unsigned int *>(value.data_ptr)[0];
+        auto actual_value = load_value<unsigned int>(value);
         return static_asprintf("%u", actual_value);
     }
 
@@ -72,27 +147,27 @@ static const char *value_to_string(const ConfigValue &value)
 static void value_from_string(ConfigValue &value, const char *string)
 {
     if(value.type == CONFIG_INT) {
-        std::sscanf(string, "%d", reinterpret_cast<int *>(value.data_ptr));
+        scan_value<int>(value, "%d", string);
         return;
     }
 
     if(value.type == CONFIG_BOOL) {
-        reinterpret_cast<bool *>(value.data_ptr)[0] = std::strcmp(string, "false") || !std::strcmp(string, "true");
+        store_value<bool>(value, std::strcmp(string, "false") || !std::strcmp(string, "true"));
         return;
     }
 
     if(value.type == CONFIG_FLOAT) {
-        std::sscanf(string, "%f", reinterpret_cast<float *>(value.data_ptr));
+        scan_value<float>(value, "%f", string);
         return;
     }
 
     if(value.type == CONFIG_SIZE_T) {
-        std::sscanf(string, "%zu", reinterpret_cast<std::size_t *>(value.data_ptr));
+        scan_value<std::size_t>(value, "%zu", string);
         return;
     }
 
     if(value.type == CONFIG_UINT) {
-        std::sscanf(string, "%u", reinterpret_cast<unsigned int *>(value.data_ptr));
+        scan_value<unsigned int>(value, "%u", string);
         return;
     }
 
@@ -102,55 +177,209 @@ static void value_from_string(ConfigValue &value, const char *string)
     }
 }
 
-void config::load(const char *filename)
+// Parses the file in-place; keys and values are views into
+// `source` and are null-terminated so they can double as C strings
+static void parse_file(const char *filename, std::vector<char> &source, std::unordered_map<std::string_view, std::string_view> &values)
 {
-    std::stringstream stream;
+    source.clear();
+    values.clear();
 
     if(auto file = PHYSFS_openRead(filename)) {
         auto count = PHYSFS_fileLength(file);
-        auto source = std::string(std::size_t(count + 1), char(0x00));
-        PHYSFS_readBytes(file, source.data(), source.size());
+        source.resize(std::size_t(count + 1), char(0x00));
+        source.resize(1 + cxpr::max<PHYSFS_sint64>(0, PHYSFS_readBytes(file, source.data(), count)));
+        source.back() = char(0x00);
         PHYSFS_close(file);
-        stream.str(source);
     }
 
-    std::string line;
-    while(std::getline(stream, line)) {
-        auto c_split = strtools::split(line, "#");
-        auto c_pair = strtools::trim_whitespace(c_split[0]);
+    if(source.empty())
+        return;
+
+    // Every pair takes up at least a line so the
+    // line count bounds the number of buckets needed
+    values.reserve(1 + static_cast<std::size_t>(std::count(source.cbegin(), source.cend(), '\n')));
+
+    std::string_view remaining(source.data(), source.size() - 1);
+    std::string_view line;
 
-        if(strtools::is_whitespace(c_pair)) {
+    while(strtools::next_token(remaining, '\n', line)) {
+        auto comment = strtools::find_char(line, '#');
+        auto c_pair = strtools::trim_whitespace_view(line.substr(0, comment));
+
+        if(c_pair.empty()) {
             // The meaningful part of the line
             // is empty, assume it's just a separation
             continue;
         }
 
-        // Because the value string may contain
-        // stray equal signs, so strtools::split won't work here
-        auto kv_separator = c_pair.find_first_of('=');
+        // Only the first equal sign counts
+        // as the value string may contain stray ones
+        auto kv_separator = strtools::find_char(c_pair, '=');
 
-        if(kv_separator == std::string::npos) {
+        if(kv_separator == std::string_view::npos) {
             // Consider any key-value pair without a valid
             // separator between the key and the value as invalid
-            QF_notice("config: %s: invalid key-value pair: '%s' %zu %02X", filename, c_pair.c_str(), c_pair.size());
+            QF_notice("config: %s: invalid key-value pair: '%.*s'", filename, static_cast<int>(c_pair.size()), c_pair.data());
             continue;
         }
 
-        auto kv_key = strtools::trim_whitespace(c_pair.substr(0, kv_separator));
-        auto kv_value = strtools::trim_whitespace(c_pair.substr(kv_separator + 1));
+        auto kv_key = strtools::trim_whitespace_view(c_pair.substr(0, kv_separator));
+        auto kv_value = strtools::trim_whitespace_view(c_pair.substr(kv_separator + 1));
 
-        const auto it = vmap.find(kv_key);
+        // Both are followed by either whitespace, the
+        // separator, a comment, a newline or the terminator
+        const_cast<char *>(kv_key.data())[kv_key.size()] = char(0x00);
+        const_cast<char *>(kv_value.data())[kv_value.size()] = char(0x00);
 
-        if(it != vmap.cend()) {
-            if(it->second.flags & FCONFIG_NO_LOAD)
-                continue;
-            value_from_string(it->second, kv_value.c_str());
+        values.insert_or_assign(kv_key, kv_value);
+    }
+}
+
+static void invoke_callbacks(const std::string &name)
+{
+    const auto range = callbacks.equal_range(name);
+
+    for(auto it = range.first; it != range.second; ++it) {
+        it->second(name.c_str());
+    }
+}
+
+static bool apply_value(std::string_view name, const char *string)
+{
+    const auto it = vmap.find(name);
+
+    if(it == vmap.cend())
+        return false;
+    if(it->second.flags & FCONFIG_NO_LOAD)
+        return false;
+    value_from_string(it->second, string);
+    return true;
+}
+
+static PHYSFS_sint64 get_modtime(const char *filename)
+{
+    PHYSFS_Stat stat;
+
+    if(PHYSFS_stat(filename, &stat))
+        return stat.modtime;
+    return -1;
+}
+
+#ifdef __linux__
+static void watch_file(ConfigFile &file)
+{
+    if(watch_fd < 0)
+        return;
+
+    const char *real_dir = PHYSFS_getRealDir(file.filename.c_str());
+
+    if(real_dir == nullptr) {
+        QF_verbose("config: %s: not watching a file that doesn't exist", file.filename.c_str());
+        return;
+    }
+
+    const auto path = std::filesystem::path(real_dir) / file.filename;
+    const auto directory = path.parent_path();
+
+    if(!std::filesystem::is_directory(directory)) {
+        // The file lives inside an archive
+        return;
+    }
+
+    // Editors tend to save files by writing a new one and
+    // renaming it over the original, so the directory is watched
+    // rather than the file; the file's inode changes every time
+    const int wd = inotify_add_watch(watch_fd, directory.string().c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+
+    if(wd < 0) {
+        QF_warning("config: inotify_add_watch: %s: %s", directory.string().c_str(), std::strerror(errno));
+        return;
+    }
+
+    file.watch_descriptor = wd;
+    file.watch_name = path.filename().string();
+}
+#endif
+
+static void reload_file(std::size_t index)
+{
+    auto &file = files[index];
+
+    std::vector<char> source;
+    std::unordered_map<std::string_view, std::string_view> values;
+    parse_file(file.filename.c_str(), source, values);
+
+    for(const auto &it : values) {
+        const auto previous = file.values.find(it.first);
+
+        if((previous != file.values.cend()) && (previous->second == it.second)) {
+            // The value didn't change
+            continue;
+        }
+
+        // Files loaded later override this
+        // one so their values must stay in effect
+        bool overridden = false;
+
+        for(std::size_t i = index + 1; i < files.size(); ++i) {
+            if(files[i].values.count(it.first)) {
+                overridden = true;
+                break;
+            }
+        }
+
+        if(overridden)
+            continue;
+
+        if(apply_value(it.first, it.second.data())) {
+            QF_inform("config: %s: %s = %s", file.filename.c_str(), it.first.data(), it.second.data());
+            invoke_callbacks(std::string(it.first));
         }
     }
+
+    // Moving a vector keeps its storage
+    // so the views in `values` stay valid
+    file.source = std::move(source);
+    file.values = std::move(values);
+    file.modtime = get_modtime(file.filename.c_str());
+}
+
+void config::load(const char *filename)
+{
+    QF_memory_tag(MEMTAG_CONFIG);
+
+    ConfigFile *file = nullptr;
+
+    for(auto &it : files) {
+        if(it.filename == filename) {
+            file = &it;
+            break;
+        }
+    }
+
+    if(file == nullptr) {
+        file = &files.emplace_back();
+        file->filename = filename;
+        file->watch_descriptor = -1;
+
+#ifdef __linux__
+        watch_file(*file);
+#endif
+    }
+
+    file->modtime = get_modtime(filename);
+
+    parse_file(filename, file->source, file->values);
+
+    for(const auto &it : file->values) {
+        apply_value(it.first, it.second.data());
+    }
 }
 
 void config::save(const char *filename)
 {
+    QF_memory_tag(MEMTAG_CONFIG);
+
     std::stringstream stream;
 
     for(const auto &it : vmap) {
@@ -168,37 +397,204 @@ void config::save(const char *filename)
     }
 }
 
+void config::watch(void)
+{
+    if(watch_enabled)
+        return;
+    watch_enabled = true;
+
+#ifdef __linux__
+    watch_fd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+
+    if(watch_fd < 0) {
+        QF_warning("config: inotify_init1: %s", std::strerror(errno));
+        return;
+    }
+
+    for(auto &file : files) {
+        watch_file(file);
+    }
+#else
+    watch_next_poll = std::chrono::steady_clock::now() + WATCH_POLL_INTERVAL;
+#endif
+}
+
+void config::unwatch(void)
+{
+    if(!watch_enabled)
+        return;
+    watch_enabled = false;
+
+#ifdef __linux__
+    if(watch_fd >= 0) {
+        close(watch_fd);
+        watch_fd = -1;
+    }
+#endif
+
+    for(auto &file : files) {
+        file.watch_descriptor = -1;
+        file.watch_name.clear();
+    }
+}
+
+void config::update(void)
+{
+    QF_memory_tag(MEMTAG_CONFIG);
+
+    QF_profile_zone("config::update");
+
+    if(!watch_enabled)
+        return;
+
+    std::vector<std::size_t> changed;
+
+#ifdef __linux__
+    if(watch_fd < 0)
+        return;
+
+    alignas(struct inotify_event) char buffer[4096];
+
+    while(true) {
+        const auto count = read(watch_fd, buffer, sizeof(buffer));
+
+        if(count <= 0)
+            break;
+
+        for(ssize_t offset = 0; offset < count;) {
+            const auto event = reinterpret_cast<const struct inotify_event *>(buffer + offset);
+            offset += sizeof(struct inotify_event) + event->len;
+
+            if(event->len == 0)
+                continue;
+
+            for(std::size_t i = 0; i < files.size(); ++i) {
+                if((files[i].watch_descriptor == event->wd) && (files[i].watch_name == event->name)) {
+                    if(std::find(changed.cbegin(), changed.cend(), i) == changed.cend()) {
+                        changed.push_back(i);
+                    }
+                }
+            }
+        }
+    }
+#else
+    const auto now = std::chrono::steady_clock::now();
+
+    if(now < watch_next_poll)
+        return;
+    watch_next_poll = now + WATCH_POLL_INTERVAL;
+
+    for(std::size_t i = 0; i < files.size(); ++i) {
+        if(get_modtime(files[i].filename.c_str()) != files[i].modtime) {
+            changed.push_back(i);
+        }
+    }
+#endif
+
+    // Re-reading in load order keeps the
+    // override checks in reload_file consistent
+    std::sort(changed.begin(), changed.end());
+
+    for(const auto index : changed) {
+        reload_file(index);
+    }
+}
+
+void config::add_callback(const char *name, QF_ConfigCallback callback)
+{
+    QF_memory_tag(MEMTAG_CONFIG);
+
+    callbacks.emplace(name, callback);
+}
+
 void config::add(const char *name, int &vref, QF_ConfigFlags flags)
 {
-    vmap[name] = ConfigValue{flags, CONFIG_INT, sizeof(int), &vref};
+    QF_memory_tag(MEMTAG_CONFIG);
+
+    vmap[name] = ConfigValue{flags, CONFIG_INT, sizeof(int), &vref, nullptr};
 }
 
 void config::add(const char *name, bool &vref, QF_ConfigFlags flags)
 {
-    vmap[name] = ConfigValue{flags, CONFIG_BOOL, sizeof(bool), &vref};
+    QF_memory_tag(MEMTAG_CONFIG);
+
+    vmap[name] = ConfigValue{flags, CONFIG_BOOL, sizeof(bool), &vref, nullptr};
 }
 
 void config::add(const char *name, float &vref, QF_ConfigFlags flags)
 {
-    vmap[name] = ConfigValue{flags, CONFIG_FLOAT, sizeof(float), &vref};
+    QF_memory_tag(MEMTAG_CONFIG);
+
+    vmap[name] = ConfigValue{flags, CONFIG_FLOAT, sizeof(float), &vref, nullptr};
 }
 
 void config::add(const char *name, std::size_t &vref, QF_ConfigFlags flags)
 {
-    vmap[name] = ConfigValue{flags, CONFIG_SIZE_T, sizeof(std::size_t), &vref};
+    QF_memory_tag(MEMTAG_CONFIG);
+
+    vmap[name] = ConfigValue{flags, CONFIG_SIZE_T, sizeof(std::size_t), &vref, nullptr};
 }
 
 void config::add(const char *name, unsigned int &vref, QF_ConfigFlags flags)
 {
-    vmap[name] = ConfigValue{flags, CONFIG_UINT, sizeof(unsigned int), &vref};
+    QF_memory_tag(MEMTAG_CONFIG);
+
+    vmap[name] = ConfigValue{flags, CONFIG_UINT, sizeof(unsigned int), &vref, nullptr};
 }
 
 void config::add(const char *name, char *vref, std::size_t size, QF_ConfigFlags flags)
 {
+    QF_memory_tag(MEMTAG_CONFIG);
+
     QF_assert_msg(vref && size, "invalid string reference");
-    vmap[name] = ConfigValue{flags, CONFIG_STRING, size, vref};
+    vmap[name] = ConfigValue{flags, CONFIG_STRING, size, vref, nullptr};
+}
+
+template<typename T>
+ConfigHandle<T> config::add(const char *name, T value, QF_ConfigFlags flags)
+{
+    QF_memory_tag(MEMTAG_CONFIG);
+
+    unsigned int type;
+
+    if constexpr(std::is_same_v<T, int>)
+        type = CONFIG_INT;
+    else if constexpr(std::is_same_v<T, bool>)
+        type = CONFIG_BOOL;
+    else if constexpr(std::is_same_v<T, float>)
+        type = CONFIG_FLOAT;
+    else if constexpr(std::is_same_v<T, std::size_t>)
+        type = CONFIG_SIZE_T;
+    else if constexpr(std::is_same_v<T, unsigned int>)
+        type = CONFIG_UINT;
+    else static_assert(!sizeof(T), "unsupported config value type");
+
+    const auto it = vmap.find(name);
+
+    if((it != vmap.cend()) && it->second.cell && (it->second.type == type)) {
+        // Multiple systems may want to share a variable
+        it->second.flags = flags;
+        return ConfigHandle<T>{it->second.cell};
+    }
+
+    std::uint64_t bits = UINT64_C(0);
+    std::memcpy(&bits, &value, sizeof(T));
+
+    ConfigHandle<T> handle = {&cells.emplace_back()};
+    handle.cell->bits.store(bits, std::memory_order_relaxed);
+    handle.cell->generation.store(UINT32_C(0), std::memory_order_relaxed);
+
+    vmap[name] = ConfigValue{flags, type, sizeof(T), nullptr, handle.cell};
+
+    return handle;
 }
 
+template ConfigHandle<int> config::add<int>(const char *name, int value, QF_ConfigFlags flags);
+template ConfigHandle<bool> config::add<bool>(const char *name, bool value, QF_ConfigFlags flags);
+template ConfigHandle<float> config::add<float>(const char *name, float value, QF_ConfigFlags flags);
+template ConfigHandle<std::size_t> config::add<std::size_t>(const char *name, std::size_t value, QF_ConfigFlags flags);
+template ConfigHandle<unsigned int> config::add<unsigned int>(const char *name, unsigned int value, QF_ConfigFlags flags);
+
 const char *config::get_string(const char *name)
 {
     const auto it = vmap.find(name);
@@ -221,4 +617,5 @@ void config::set_string(const char *name, const char *string)
     }
 
     value_from_string(it->second, string);
+    invoke_callbacks(it->first);
 }
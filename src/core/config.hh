@@ -12,6 +12,34 @@ enum QF_ConfigFlags : unsigned int {
     FCONFIG_NO_SAVE = 0x0002, ///< Variable is ignored during saving
 };
 
+/**
+ * A function called whenever a config
+ * value changes after it was first loaded
+ * @param name Config value name
+ */
+using QF_ConfigCallback = void (*)(const char *name);
+
+/**
+ * Config-owned storage of a handle-bound variable;
+ * values are kept as raw bits so that a single atomic
+ * type can back every supported scalar type
+ */
+struct ConfigCell final {
+    std::atomic<std::uint64_t> bits;        ///< Value bits, zero-extended
+    std::atomic<std::uint32_t> generation;  ///< Incremented on every change
+};
+
+/**
+ * A typed reference to a config variable that
+ * can be safely read from any thread while the
+ * main thread loads or changes the configuration
+ * @note Handles stay valid for the lifetime of the program
+ */
+template<typename T>
+struct ConfigHandle final {
+    ConfigCell *cell;
+};
+
 namespace config
 {
 /**
@@ -30,6 +58,39 @@ void load(const char *filename);
 void save(const char *filename);
 } // namespace config
 
+namespace config
+{
+/**
+ * Starts watching loaded config files for changes;
+ * files loaded afterwards are watched as well
+ * @note On Linux this uses inotify; elsewhere the
+ * files' modification times are polled every second
+ */
+void watch(void);
+
+/**
+ * Stops watching config files
+ */
+void unwatch(void);
+
+/**
+ * Re-reads config files that changed since the last call
+ * and applies the values that differ from the previous
+ * version of the file, invoking their callbacks; values
+ * overridden by a file loaded later are left alone
+ * @note Should be called once per frame from the main thread
+ */
+void update(void);
+
+/**
+ * Registers a function to call whenever a value
+ * is changed by a reload or by config::set_string
+ * @param name Config value name
+ * @param callback Callback function
+ */
+void add_callback(const char *name, QF_ConfigCallback callback);
+} // namespace config
+
 namespace config
 {
 void add(const char *name, int &vref, QF_ConfigFlags flags = FCONFIG_NOTHING);
@@ -38,6 +99,52 @@ void add(const char *name, float &vref, QF_ConfigFlags flags = FCONFIG_NOTHING);
 void add(const char *name, std::size_t &vref, QF_ConfigFlags flags = FCONFIG_NOTHING);
 void add(const char *name, unsigned int &vref, QF_ConfigFlags flags = FCONFIG_NOTHING);
 void add(const char *name, char *vref, std::size_t size, QF_ConfigFlags flags = FCONFIG_NOTHING);
+
+/**
+ * Registers a config variable owned by the config
+ * registry itself; unlike the reference-binding overloads,
+ * the value is stored atomically and can be accessed from
+ * worker threads through the returned handle
+ * @param name Config value name
+ * @param value Default value
+ * @param flags Config flags
+ * @returns A handle to the variable
+ * @note `T` must be one of int, bool, float, std::size_t or unsigned int;
+ * if the name is already registered with the same type, the existing
+ * handle is returned and its value is left untouched
+ */
+template<typename T>
+ConfigHandle<T> add(const char *name, T value, QF_ConfigFlags flags = FCONFIG_NOTHING);
+} // namespace config
+
+namespace config
+{
+/**
+ * Reads a handle-bound value; thread-safe
+ * @param handle Config handle
+ * @returns Current value
+ */
+template<typename T>
+static inline T get(const ConfigHandle<T> &handle);
+
+/**
+ * Changes a handle-bound value; thread-safe
+ * @param handle Config handle
+ * @param value New value
+ */
+template<typename T>
+static inline void set(const ConfigHandle<T> &handle, T value);
+
+/**
+ * Figure out how many times a value was changed;
+ * systems that cache anything derived from a config
+ * value can compare this against a remembered number
+ * instead of comparing the values themselves
+ * @param handle Config handle
+ * @returns Change generation
+ */
+template<typename T>
+static inline std::uint32_t generation(const ConfigHandle<T> &handle);
 } // namespace config
 
 namespace config
@@ -60,4 +167,32 @@ namespace config
 void set_string(const char *name, const char *string);
 } // namespace config
 
+template<typename T>
+static inline T config::get(const ConfigHandle<T> &handle)
+{
+    static_assert(sizeof(T) <= sizeof(std::uint64_t));
+    const std::uint64_t bits = handle.cell->bits.load(std::memory_order_acquire);
+    T result;
+    std::memcpy(&result, &bits, sizeof(T));
+    return result;
+}
+
+template<typename T>
+static inline void config::set(const ConfigHandle<T> &handle, T value)
+{
+    static_assert(sizeof(T) <= sizeof(std::uint64_t));
+    std::uint64_t bits = UINT64_C(0);
+    std::memcpy(&bits, &value, sizeof(T));
+
+    if(handle.cell->bits.exchange(bits, std::memory_order_acq_rel) != bits) {
+        handle.cell->generation.fetch_add(1, std::memory_order_release);
+    }
+}
+
+template<typename T>
+static inline std::uint32_t config::generation(const ConfigHandle<T> &handle)
+{
+    return handle.cell->generation.load(std::memory_order_acquire);
+}
+
 #endif /* CORE_CONFIG_HH */
@@ -1,6 +1,23 @@
 #include "core/precompiled.hh"
 #include "core/crc64.hh"
 
+#include "core/byteorder.hh"
+#include "core/constexpr.hh"
+#include "core/jobs.hh"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define QF_CRC64_CLMUL 1
+#include <immintrin.h>
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+#endif
+
+/**
+ * ECMA-182 polynomial without the implicit x^64 term
+ */
+constexpr static std::uint64_t CRC_POLY = UINT64_C(0x42F0E1EBA9EA3693);
+
 /**
  * The lookup table for CRC64 checksum; this lookup
  * table is generated using ECMA-182 compilant parameters:
@@ -9,7 +26,7 @@
  * - Final xor: `0x0000000000000000`
  * @see [CRC Calculator](https://www.sunshine2k.de/coding/javascript/crc/crc_js.html)
  */
-static const std::uint64_t crc_table[256] = {
+constexpr static std::uint64_t crc_table[256] = {
     0x0000000000000000, 0x42F0E1EBA9EA3693, 0x85E1C3D753D46D26, 0xC711223CFA3E5BB5,
     0x493366450E42ECDF, 0x0BC387AEA7A8DA4C, 0xCCD2A5925D9681F9, 0x8E224479F47CB76A,
     0x9266CC8A1C85D9BE, 0xD0962D61B56FEF2D, 0x17870F5D4F51B498, 0x5577EEB6E6BB820B,
@@ -76,12 +93,349 @@ static const std::uint64_t crc_table[256] = {
     0x5DEDC41A34BBEEB2, 0x1F1D25F19D51D821, 0xD80C07CD676F8394, 0x9AFCE626CE85B507,
 };
 
-std::uint64_t crc64::get(const void *buffer, std::size_t size, std::uint64_t combine)
+
+struct SlicingTables final {
+    std::uint64_t data[16][256];
+};
+
+// Table K advances a byte through K additional zero bytes,
+// which lets slicing-by-N process N bytes with N independent lookups
+constexpr static SlicingTables make_slicing_tables(void)
 {
-    auto data = reinterpret_cast<const std::uint8_t *>(buffer);
+    SlicingTables result = {};
+
+    for(std::size_t i = 0; i < 256; ++i)
+        result.data[0][i] = crc_table[i];
+
+    for(std::size_t k = 1; k < 16; ++k) {
+        for(std::size_t i = 0; i < 256; ++i) {
+            const std::uint64_t prev = result.data[k - 1][i];
+            result.data[k][i] = (prev << 8) ^ crc_table[(prev >> 56) & 0xFF];
+        }
+    }
+
+    return result;
+}
+
+constexpr static SlicingTables slicing = make_slicing_tables();
+
+static std::uint64_t get_slicing(const std::uint8_t *data, std::size_t size, std::uint64_t crc)
+{
+    const auto &t = slicing.data;
+
+    while(size >= 16) {
+        const std::uint64_t a = crc ^ byteorder::load_big<std::uint64_t>(data + 0);
+        const std::uint64_t b = byteorder::load_big<std::uint64_t>(data + 8);
+
+        crc  = t[15][(a >> 56) & 0xFF] ^ t[14][(a >> 48) & 0xFF] ^ t[13][(a >> 40) & 0xFF] ^ t[12][(a >> 32) & 0xFF];
+        crc ^= t[11][(a >> 24) & 0xFF] ^ t[10][(a >> 16) & 0xFF] ^ t[ 9][(a >>  8) & 0xFF] ^ t[ 8][(a >>  0) & 0xFF];
+        crc ^= t[ 7][(b >> 56) & 0xFF] ^ t[ 6][(b >> 48) & 0xFF] ^ t[ 5][(b >> 40) & 0xFF] ^ t[ 4][(b >> 32) & 0xFF];
+        crc ^= t[ 3][(b >> 24) & 0xFF] ^ t[ 2][(b >> 16) & 0xFF] ^ t[ 1][(b >>  8) & 0xFF] ^ t[ 0][(b >>  0) & 0xFF];
+
+        data += 16;
+        size -= 16;
+    }
+
+    if(size >= 8) {
+        const std::uint64_t a = crc ^ byteorder::load_big<std::uint64_t>(data);
+
+        crc  = t[7][(a >> 56) & 0xFF] ^ t[6][(a >> 48) & 0xFF] ^ t[5][(a >> 40) & 0xFF] ^ t[4][(a >> 32) & 0xFF];
+        crc ^= t[3][(a >> 24) & 0xFF] ^ t[2][(a >> 16) & 0xFF] ^ t[1][(a >>  8) & 0xFF] ^ t[0][(a >>  0) & 0xFF];
+
+        data += 8;
+        size -= 8;
+    }
+
     for(std::size_t i = 0; i < size; ++i)
-        combine = crc_table[((combine >> 56) ^ data[i]) & 0xFF] ^ (combine << 8);
-    return combine;
+        crc = crc_table[((crc >> 56) ^ data[i]) & 0xFF] ^ (crc << 8);
+    return crc;
+}
+
+#if QF_CRC64_CLMUL
+
+// Computes x^n mod P; the folding constants are derived
+// from the polynomial at compile time instead of being magic
+constexpr static std::uint64_t xpow_mod(unsigned int n)
+{
+    std::uint64_t value = UINT64_C(1);
+
+    for(unsigned int i = 0; i < n; ++i) {
+        const bool carry = value & UINT64_C(0x8000000000000000);
+        value <<= 1;
+        if(carry)
+            value ^= CRC_POLY;
+    }
+
+    return value;
+}
+
+// Computes floor(x^128 / P) without the x^64 term
+constexpr static std::uint64_t barrett_mu(void)
+{
+    // Remainder window holds 65 significant bits: the
+    // implicit x^64 term and the lower 64 bits of the divisor
+    std::uint64_t quotient = UINT64_C(0);
+    std::uint64_t remainder = UINT64_C(0);
+    bool remainder_top = true;
+
+    for(unsigned int i = 0; i < 65; ++i) {
+        quotient <<= 1;
+
+        if(remainder_top) {
+            quotient |= UINT64_C(1);
+            remainder ^= CRC_POLY;
+        }
+
+        remainder_top = remainder & UINT64_C(0x8000000000000000);
+        remainder <<= 1;
+    }
+
+    return quotient;
+}
+
+constexpr static std::uint64_t K_FOLD_512_HI = xpow_mod(512 + 64);
+constexpr static std::uint64_t K_FOLD_512_LO = xpow_mod(512);
+constexpr static std::uint64_t K_FOLD_128_HI = xpow_mod(128 + 64);
+constexpr static std::uint64_t K_FOLD_128_LO = xpow_mod(128);
+constexpr static std::uint64_t K_BARRETT_MU = barrett_mu();
+
+#if defined(__GNUC__) || defined(__clang__)
+#define QF_CRC64_TARGET __attribute__((target("pclmul,ssse3")))
+#else
+#define QF_CRC64_TARGET
+#endif
+
+QF_CRC64_TARGET static inline __m128i clmul_load(const std::uint8_t *data, __m128i reverse)
+{
+    return _mm_shuffle_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i *>(data)), reverse);
+}
+
+QF_CRC64_TARGET static inline __m128i clmul_fold(__m128i value, __m128i constants)
+{
+    return _mm_xor_si128(_mm_clmulepi64_si128(value, constants, 0x11), _mm_clmulepi64_si128(value, constants, 0x00));
+}
+
+QF_CRC64_TARGET static inline std::uint64_t clmul_lo(__m128i value)
+{
+    return static_cast<std::uint64_t>(_mm_cvtsi128_si64(value));
+}
+
+QF_CRC64_TARGET static inline std::uint64_t clmul_hi(__m128i value)
+{
+    return static_cast<std::uint64_t>(_mm_cvtsi128_si64(_mm_unpackhi_epi64(value, value)));
+}
+
+/**
+ * Carry-less multiplication folding; the message is kept
+ * in four 128-bit accumulators (bit 127 being the earliest
+ * message bit) that are repeatedly moved forward by 512 bits
+ * modulo P, then folded into one and Barrett-reduced
+ * @see Intel's [Fast CRC Computation for Generic Polynomials Using PCLMULQDQ Instruction](https://www.intel.com/content/dam/www/public/us/en/documents/white-papers/fast-crc-computation-generic-polynomials-pclmulqdq-paper.pdf)
+ */
+QF_CRC64_TARGET static std::uint64_t get_clmul(const std::uint8_t *data, std::size_t size, std::uint64_t crc)
+{
+    if(size < 128)
+        return get_slicing(data, size, crc);
+
+    const __m128i reverse = _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15);
+    const __m128i fold_512 = _mm_set_epi64x(static_cast<long long>(K_FOLD_512_HI), static_cast<long long>(K_FOLD_512_LO));
+    const __m128i fold_128 = _mm_set_epi64x(static_cast<long long>(K_FOLD_128_HI), static_cast<long long>(K_FOLD_128_LO));
+
+    // The initial value is equivalent to being
+    // XORed into the first eight message bytes
+    __m128i x0 = _mm_xor_si128(clmul_load(data + 0, reverse), _mm_set_epi64x(static_cast<long long>(crc), 0));
+    __m128i x1 = clmul_load(data + 16, reverse);
+    __m128i x2 = clmul_load(data + 32, reverse);
+    __m128i x3 = clmul_load(data + 48, reverse);
+
+    data += 64;
+    size -= 64;
+
+    while(size >= 64) {
+        x0 = _mm_xor_si128(clmul_fold(x0, fold_512), clmul_load(data + 0, reverse));
+        x1 = _mm_xor_si128(clmul_fold(x1, fold_512), clmul_load(data + 16, reverse));
+        x2 = _mm_xor_si128(clmul_fold(x2, fold_512), clmul_load(data + 32, reverse));
+        x3 = _mm_xor_si128(clmul_fold(x3, fold_512), clmul_load(data + 48, reverse));
+
+        data += 64;
+        size -= 64;
+    }
+
+    x1 = _mm_xor_si128(x1, clmul_fold(x0, fold_128));
+    x2 = _mm_xor_si128(x2, clmul_fold(x1, fold_128));
+    x3 = _mm_xor_si128(x3, clmul_fold(x2, fold_128));
+
+    while(size >= 16) {
+        x3 = _mm_xor_si128(clmul_fold(x3, fold_128), clmul_load(data, reverse));
+        data += 16;
+        size -= 16;
+    }
+
+    // The checksum is (X * x^64) mod P; first bring
+    // that down to 128 bits, then Barrett-reduce to 64 bits
+    const __m128i shifted = _mm_clmulepi64_si128(x3, _mm_cvtsi64_si128(static_cast<long long>(K_FOLD_128_LO)), 0x01);
+    const std::uint64_t t_hi = clmul_hi(shifted) ^ clmul_lo(x3);
+    const std::uint64_t t_lo = clmul_lo(shifted);
+
+    const __m128i barrett = _mm_set_epi64x(static_cast<long long>(CRC_POLY), static_cast<long long>(K_BARRETT_MU));
+    const __m128i q_part = _mm_clmulepi64_si128(_mm_cvtsi64_si128(static_cast<long long>(t_hi)), barrett, 0x00);
+    const std::uint64_t q = t_hi ^ clmul_hi(q_part);
+    const __m128i r_part = _mm_clmulepi64_si128(_mm_cvtsi64_si128(static_cast<long long>(q)), barrett, 0x10);
+
+    return get_slicing(data, size, t_lo ^ clmul_lo(r_part));
+}
+
+static bool cpu_has_clmul(void)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    int info[4];
+    __cpuid(info, 1);
+    return (info[2] & (1 << 1)) && (info[2] & (1 << 9));
+#else
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("pclmul") && __builtin_cpu_supports("ssse3");
+#endif
+}
+
+#endif /* QF_CRC64_CLMUL */
+
+// Parallel checksumming is not worth spinning
+// threads up for chunks smaller than this
+constexpr static std::size_t PARALLEL_MIN_CHUNK = 1048576;
+
+// Applies a 64x64 GF(2) matrix stored as 64 columns to a vector
+static std::uint64_t gf2_matrix_times(const std::uint64_t *matrix, std::uint64_t vector)
+{
+    std::uint64_t result = UINT64_C(0);
+
+    for(std::size_t i = 0; vector; ++i, vector >>= 1) {
+        if(vector & UINT64_C(1)) {
+            result ^= matrix[i];
+        }
+    }
+
+    return result;
+}
+
+static void gf2_matrix_square(std::uint64_t *square, const std::uint64_t *matrix)
+{
+    for(std::size_t i = 0; i < 64; ++i) {
+        square[i] = gf2_matrix_times(matrix, matrix[i]);
+    }
+}
+
+using PFN_crc64_impl = std::uint64_t(*)(const std::uint8_t *data, std::size_t size, std::uint64_t crc);
+
+static PFN_crc64_impl select_implementation(void)
+{
+#if QF_CRC64_CLMUL
+    if(cpu_has_clmul())
+        return &get_clmul;
+#endif
+    return &get_slicing;
+}
+
+std::uint64_t crc64::get(const void *buffer, std::size_t size, std::uint64_t combine)
+{
+    static const PFN_crc64_impl implementation = select_implementation();
+    return implementation(reinterpret_cast<const std::uint8_t *>(buffer), size, combine);
+}
+
+std::uint64_t crc64::get_scalar(const void *buffer, std::size_t size, std::uint64_t combine)
+{
+    return get_slicing(reinterpret_cast<const std::uint8_t *>(buffer), size, combine);
+}
+
+std::uint64_t crc64::combine(std::uint64_t crc_a, std::uint64_t crc_b, std::uint64_t len_b)
+{
+    std::uint64_t odd[64];
+    std::uint64_t even[64];
+
+    if(len_b == UINT64_C(0)) {
+        // Nothing to shift crc_a through
+        return crc_a ^ crc_b;
+    }
+
+    // Operator for a single zero bit: shift
+    // left and reduce by the polynomial on carry
+    for(std::size_t i = 0; i < 63; ++i)
+        odd[i] = UINT64_C(1) << (i + 1);
+    odd[63] = CRC_POLY;
+
+    // Two and four zero bits; the loop below
+    // starts from eight bits which is a single byte
+    gf2_matrix_square(even, odd);
+    gf2_matrix_square(odd, even);
+
+    do {
+        gf2_matrix_square(even, odd);
+        if(len_b & UINT64_C(1))
+            crc_a = gf2_matrix_times(even, crc_a);
+        len_b >>= 1;
+
+        if(len_b == UINT64_C(0))
+            break;
+
+        gf2_matrix_square(odd, even);
+        if(len_b & UINT64_C(1))
+            crc_a = gf2_matrix_times(odd, crc_a);
+        len_b >>= 1;
+    } while(len_b);
+
+    return crc_a ^ crc_b;
+}
+
+struct ParallelChecksum final {
+    const std::uint8_t *data;
+    std::size_t size;
+    std::size_t chunk_size;
+    std::size_t num_chunks;
+    std::vector<std::uint64_t> partials;
+};
+
+static void checksum_chunk(void *data, std::size_t index)
+{
+    auto checksum = static_cast<ParallelChecksum *>(data);
+
+    // Job indices start at zero but chunk
+    // zero is handled by the calling thread
+    const std::size_t chunk = index + 1;
+    const std::size_t offset = chunk * checksum->chunk_size;
+    const std::size_t length = (chunk == checksum->num_chunks - 1) ? (checksum->size - offset) : checksum->chunk_size;
+    checksum->partials[chunk] = crc64::get(checksum->data + offset, length, UINT64_C(0));
+}
+
+std::uint64_t crc64::get_parallel(const void *buffer, std::size_t size, std::uint64_t combine, unsigned int num_threads)
+{
+    if(num_threads == 0U)
+        num_threads = jobs::num_workers() + 1U;
+    num_threads = static_cast<unsigned int>(cxpr::min<std::size_t>(num_threads, size / PARALLEL_MIN_CHUNK));
+
+    if(num_threads <= 1U) {
+        // Not enough data to make it worth it
+        return crc64::get(buffer, size, combine);
+    }
+
+    ParallelChecksum checksum;
+    checksum.data = reinterpret_cast<const std::uint8_t *>(buffer);
+    checksum.size = size;
+    checksum.chunk_size = size / num_threads;
+    checksum.num_chunks = num_threads;
+    checksum.partials.resize(num_threads);
+
+    // The calling thread takes the first chunk
+    // since it's the only one with a non-zero seed
+    JobCounter counter;
+    jobs::submit_batch(&checksum_chunk, &checksum, num_threads - 1U, &counter);
+    std::uint64_t result = crc64::get(checksum.data, checksum.chunk_size, combine);
+    jobs::wait(counter);
+
+    for(unsigned int i = 1U; i < num_threads; ++i) {
+        const std::size_t length = (i == num_threads - 1U) ? (size - i * checksum.chunk_size) : checksum.chunk_size;
+        result = crc64::combine(result, checksum.partials[i], length);
+    }
+
+    return result;
 }
 
 std::uint64_t crc64::get(const std::vector<std::byte> &buffer, std::uint64_t combine)
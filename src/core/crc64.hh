@@ -4,9 +4,52 @@
 
 namespace crc64
 {
+/**
+ * Computes an ECMA-182 CRC64 checksum; uses carry-less
+ * multiplication folding when the CPU supports it and
+ * slicing-by-16 table lookups otherwise
+ * @param buffer The data
+ * @param size The data size in bytes
+ * @param combine Checksum of the preceding data, if any
+ * @returns The checksum
+ */
 std::uint64_t get(const void *buffer, std::size_t size, std::uint64_t combine = UINT64_C(0));
 std::uint64_t get(const std::vector<std::byte> &buffer, std::uint64_t combine = UINT64_C(0));
 std::uint64_t get(const std::string &buffer, std::uint64_t combine = UINT64_C(0));
+
+/**
+ * Computes an ECMA-182 CRC64 checksum using
+ * table lookups only, regardless of CPU features
+ * @param buffer The data
+ * @param size The data size in bytes
+ * @param combine Checksum of the preceding data, if any
+ * @returns The checksum, identical to crc64::get
+ */
+std::uint64_t get_scalar(const void *buffer, std::size_t size, std::uint64_t combine = UINT64_C(0));
+} // namespace crc64
+
+namespace crc64
+{
+/**
+ * Merges checksums of two adjacent ranges
+ * @param crc_a Checksum of the first range
+ * @param crc_b Checksum of the second range, computed with a zero seed
+ * @param len_b Size of the second range in bytes
+ * @returns Checksum of both ranges concatenated
+ * @note This takes O(log(len_b)) 64x64 GF(2) matrix squarings
+ */
+std::uint64_t combine(std::uint64_t crc_a, std::uint64_t crc_b, std::uint64_t len_b);
+
+/**
+ * Computes a checksum by splitting the data into jobs
+ * and merging partial results with crc64::combine
+ * @param buffer The data
+ * @param size The data size in bytes
+ * @param combine Checksum of the preceding data, if any
+ * @param num_threads Maximum amount of chunks to split into; zero means one per job system thread
+ * @returns The checksum, identical to crc64::get
+ */
+std::uint64_t get_parallel(const void *buffer, std::size_t size, std::uint64_t combine = UINT64_C(0), unsigned int num_threads = 0U);
 } // namespace crc64
 
 #endif /* CORE_CRC64_HH */
@@ -36,3 +36,41 @@ std::int64_t epoch::signed_microseconds(void)
     const auto elapsed = std::chrono::system_clock::now().time_since_epoch();
     return static_cast<std::int64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
 }
+
+std::uint64_t epoch::monotonic_ns(void)
+{
+    const auto elapsed = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count());
+}
+
+std::uint64_t epoch::monotonic_us(void)
+{
+    const auto elapsed = std::chrono::steady_clock::now().time_since_epoch();
+    return static_cast<std::uint64_t>(std::chrono::duration_cast<std::chrono::microseconds>(elapsed).count());
+}
+
+static std::uint64_t calibrate_cycles(void)
+{
+    const std::uint64_t start_ns = epoch::monotonic_ns();
+    const std::uint64_t start_cycles = epoch::cycles();
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+
+    const std::uint64_t delta_ns = epoch::monotonic_ns() - start_ns;
+    const std::uint64_t delta_cycles = epoch::cycles() - start_cycles;
+
+    if(delta_ns == 0)
+        return UINT64_C(1000000000);
+    return static_cast<std::uint64_t>(static_cast<double>(delta_cycles) * 1.0e9 / static_cast<double>(delta_ns));
+}
+
+std::uint64_t epoch::cycles_per_second(void)
+{
+    static const std::uint64_t rate = calibrate_cycles();
+    return rate;
+}
+
+std::uint64_t epoch::cycles_to_ns(std::uint64_t cycles)
+{
+    return static_cast<std::uint64_t>(static_cast<double>(cycles) * 1.0e9 / static_cast<double>(epoch::cycles_per_second()));
+}
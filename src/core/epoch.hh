@@ -50,4 +50,119 @@ std::int64_t signed_milliseconds(void);
 std::int64_t signed_microseconds(void);
 } // namespace epoch
 
+namespace epoch
+{
+/**
+ * Get monotonic nanoseconds
+ * @returns The amount of nanoseconds passed since
+ * an unspecified point in time; unlike the UNIX time
+ * functions, this never jumps when the system clock
+ * is adjusted, so it should be used to measure intervals
+ */
+std::uint64_t monotonic_ns(void);
+
+/**
+ * Get monotonic microseconds
+ * @returns The amount of microseconds passed
+ * since an unspecified point in time
+ * @see epoch::monotonic_ns
+ */
+std::uint64_t monotonic_us(void);
+} // namespace epoch
+
+namespace epoch
+{
+/**
+ * Read the CPU's cycle counter
+ * @returns Cycle count since an unspecified point in time
+ * @note This is the cheapest way to measure very short
+ * intervals; it's only meaningful within a single thread and
+ * falls back to monotonic nanoseconds on unsupported targets
+ */
+static inline std::uint64_t cycles(void);
+
+/**
+ * Figure out the rate at which epoch::cycles ticks;
+ * the first call spends about 10 milliseconds calibrating
+ * @returns Cycles per second
+ */
+std::uint64_t cycles_per_second(void);
+
+/**
+ * Converts a cycle count into nanoseconds
+ * @param cycles Cycle count
+ * @returns Nanoseconds
+ */
+std::uint64_t cycles_to_ns(std::uint64_t cycles);
+} // namespace epoch
+
+/**
+ * Adds the time spent within its scope to a
+ * counter when destroyed; the counter is not reset
+ * so one can accumulate time over many scopes
+ */
+class ScopedTimer final {
+public:
+    explicit ScopedTimer(std::uint64_t &nanoseconds);
+    ScopedTimer(const ScopedTimer &other) = delete;
+    ScopedTimer &operator=(const ScopedTimer &other) = delete;
+    ~ScopedTimer(void);
+
+private:
+    std::uint64_t &nanoseconds;
+    std::uint64_t start;
+};
+
+/**
+ * Same as ScopedTimer but counts CPU cycles;
+ * meant for microprofiling very short sections
+ * @see epoch::cycles
+ */
+class ScopedCycleTimer final {
+public:
+    explicit ScopedCycleTimer(std::uint64_t &cycles);
+    ScopedCycleTimer(const ScopedCycleTimer &other) = delete;
+    ScopedCycleTimer &operator=(const ScopedCycleTimer &other) = delete;
+    ~ScopedCycleTimer(void);
+
+private:
+    std::uint64_t &cycles;
+    std::uint64_t start;
+};
+
+static inline std::uint64_t epoch::cycles(void)
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    return static_cast<std::uint64_t>(__rdtsc());
+#elif defined(__x86_64__) || defined(__i386__)
+    return static_cast<std::uint64_t>(__builtin_ia32_rdtsc());
+#elif defined(__aarch64__)
+    std::uint64_t value;
+    asm volatile("mrs %0, cntvct_el0" : "=r"(value));
+    return value;
+#else
+    return epoch::monotonic_ns();
+#endif
+}
+
+inline ScopedTimer::ScopedTimer(std::uint64_t &nanoseconds) : nanoseconds(nanoseconds), start(epoch::monotonic_ns())
+{
+
+}
+
+inline ScopedTimer::~ScopedTimer(void)
+{
+    nanoseconds += epoch::monotonic_ns() - start;
+}
+
+inline ScopedCycleTimer::ScopedCycleTimer(std::uint64_t &cycles) : cycles(cycles), start(epoch::cycles())
+{
+
+}
+
+inline ScopedCycleTimer::~ScopedCycleTimer(void)
+{
+    cycles += epoch::cycles() - start;
+}
+
 #endif /* CORE_EPOCH_HH */
@@ -0,0 +1,90 @@
+#include "core/precompiled.hh"
+#include "core/framelimiter.hh"
+
+#include "core/constexpr.hh"
+#include "core/epoch.hh"
+#include "core/profiler.hh"
+
+// Limits for the adaptive spin margin; the lower bound
+// keeps a bit of headroom for scheduler jitter and the upper
+// one stops a single hiccup from turning waits into busy loops
+constexpr static std::uint64_t MIN_SPIN_NS = UINT64_C(200000);
+constexpr static std::uint64_t MAX_SPIN_NS = UINT64_C(4000000);
+
+// Sleeping in short slices lets the margin
+// estimate track the actual oversleep amount
+constexpr static std::uint64_t SLEEP_SLICE_NS = UINT64_C(1000000);
+
+static inline void spin_pause(void)
+{
+#if defined(_MSC_VER) && (defined(_M_X64) || defined(_M_IX86))
+    _mm_pause();
+#elif defined(__x86_64__) || defined(__i386__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    asm volatile("yield");
+#endif
+}
+
+void FrameLimiter::set_rate(FrameLimiter &limiter, float rate)
+{
+    if(rate > 0.0f)
+        limiter.interval_ns = static_cast<std::uint64_t>(1.0e9 / static_cast<double>(rate));
+    else limiter.interval_ns = UINT64_C(0);
+
+    limiter.deadline_ns = epoch::monotonic_ns() + limiter.interval_ns;
+}
+
+void FrameLimiter::wait(FrameLimiter &limiter)
+{
+    QF_profile_zone("FrameLimiter::wait");
+
+    if(limiter.interval_ns == 0) {
+        limiter.error_ns = INT64_C(0);
+        return;
+    }
+
+    std::uint64_t now = epoch::monotonic_ns();
+
+    while(now + limiter.spin_ns < limiter.deadline_ns) {
+        const std::uint64_t slice = cxpr::min(SLEEP_SLICE_NS, limiter.deadline_ns - limiter.spin_ns - now);
+        std::this_thread::sleep_for(std::chrono::nanoseconds(slice));
+
+        const std::uint64_t after = epoch::monotonic_ns();
+        const std::uint64_t overslept = (after - now > slice) ? (after - now - slice) : UINT64_C(0);
+
+        // Converge quickly when sleeps get worse
+        // and relax slowly when they get better
+        if(overslept > limiter.spin_ns)
+            limiter.spin_ns = (limiter.spin_ns + overslept) / 2;
+        else limiter.spin_ns -= (limiter.spin_ns - overslept) / 64;
+        limiter.spin_ns = cxpr::clamp(limiter.spin_ns, MIN_SPIN_NS, MAX_SPIN_NS);
+
+        now = after;
+    }
+
+    while(now < limiter.deadline_ns) {
+        spin_pause();
+        now = epoch::monotonic_ns();
+    }
+
+    limiter.error_ns = static_cast<std::int64_t>(now - limiter.deadline_ns);
+
+    if(now - limiter.deadline_ns >= limiter.interval_ns) {
+        // We've fallen behind by more than a whole frame;
+        // catching up would produce a burst of short frames
+        limiter.deadline_ns = now + limiter.interval_ns;
+    }
+    else {
+        // Scheduling off the previous deadline rather than
+        // off the current time keeps the average rate exact
+        limiter.deadline_ns += limiter.interval_ns;
+    }
+}
+
+void FrameLimiter::setup(FrameLimiter &limiter, float rate)
+{
+    limiter.spin_ns = MIN_SPIN_NS;
+    limiter.error_ns = INT64_C(0);
+    FrameLimiter::set_rate(limiter, rate);
+}
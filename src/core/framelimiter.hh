@@ -0,0 +1,39 @@
+#ifndef CORE_FRAMELIMITER_HH
+#define CORE_FRAMELIMITER_HH 1
+#pragma once
+
+/**
+ * Paces a loop to a target rate; waiting is done by
+ * sleeping for the bulk of the remaining time and then
+ * spinning for the last stretch, because the OS scheduler
+ * can easily oversleep by a millisecond or more
+ */
+class FrameLimiter final {
+public:
+    std::uint64_t interval_ns;      ///< Target frame interval, zero means unlimited
+    std::uint64_t deadline_ns;      ///< Monotonic time the current frame should end at
+    std::uint64_t spin_ns;          ///< Time left to spin after sleeping
+    std::int64_t error_ns;          ///< How late (positive) or early the last frame ended
+
+public:
+    /**
+     * Changes the target rate; the schedule
+     * restarts from the current point in time
+     * @param limiter The limiter
+     * @param rate Target rate in frames per second;
+     * zero or negative values disable limiting
+     */
+    static void set_rate(FrameLimiter &limiter, float rate);
+
+    /**
+     * Waits until the current frame's deadline
+     * and schedules the next one
+     * @param limiter The limiter
+     */
+    static void wait(FrameLimiter &limiter);
+
+public:
+    static void setup(FrameLimiter &limiter, float rate = 0.0f);
+};
+
+#endif /* CORE_FRAMELIMITER_HH */
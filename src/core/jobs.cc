@@ -0,0 +1,366 @@
+#include "core/precompiled.hh"
+#include "core/jobs.hh"
+
+#include "core/cmdline.hh"
+#include "core/config.hh"
+#include "core/logging.hh"
+#include "core/profiler.hh"
+
+// Must be a power of two
+constexpr static std::int64_t DEQUE_CAPACITY = 4096;
+constexpr static std::int64_t DEQUE_MASK = DEQUE_CAPACITY - 1;
+constexpr static unsigned int MAX_WORKERS = 64U;
+
+// Amount of failed attempts to find a job
+// before an idle worker goes to sleep
+constexpr static unsigned int IDLE_SPINS = 64U;
+
+struct Job final {
+    QF_JobFunction function;
+    void *data;
+    JobCounter *counter;
+    std::size_t index;
+};
+
+// Thieves may read a slot while its owner
+// overwrites it; the read is then discarded
+// but it still has to be atomic to be well-defined
+struct JobSlot final {
+    std::atomic<QF_JobFunction> function;
+    std::atomic<void *> data;
+    std::atomic<JobCounter *> counter;
+    std::atomic<std::size_t> index;
+};
+
+// Fixed-size Chase-Lev deque; the owning thread pushes
+// and pops at the bottom, other threads steal from the top
+// @see Lê et al., Correct and Efficient Work-Stealing for Weak Memory Models
+struct JobDeque final {
+    alignas(64) std::atomic<std::int64_t> top;
+    alignas(64) std::atomic<std::int64_t> bottom;
+    JobSlot slots[DEQUE_CAPACITY];
+};
+
+static ConfigHandle<int> num_workers_config;
+
+// Deque zero belongs to the thread that called
+// jobs::init_late, the rest belong to the workers
+static std::vector<std::unique_ptr<JobDeque>> deques;
+static std::vector<std::thread> workers;
+
+thread_local static JobDeque *local_deque = nullptr;
+thread_local static std::size_t local_index = 0;
+
+// Jobs submitted by threads outside the pool
+static std::mutex inject_mutex;
+static std::deque<Job> inject_queue;
+static std::atomic<std::size_t> num_injected = 0;
+
+static std::atomic<bool> shutdown = false;
+static std::atomic<std::size_t> num_queued = 0;
+static std::atomic<unsigned int> num_sleeping = 0;
+static std::mutex sleep_mutex;
+static std::condition_variable sleep_cv;
+
+static bool push_job(JobDeque &deque, const Job &job)
+{
+    const std::int64_t b = deque.bottom.load(std::memory_order_relaxed);
+    const std::int64_t t = deque.top.load(std::memory_order_acquire);
+
+    if(b - t >= DEQUE_CAPACITY)
+        return false;
+
+    auto &slot = deque.slots[b & DEQUE_MASK];
+    slot.function.store(job.function, std::memory_order_relaxed);
+    slot.data.store(job.data, std::memory_order_relaxed);
+    slot.counter.store(job.counter, std::memory_order_relaxed);
+    slot.index.store(job.index, std::memory_order_relaxed);
+
+    deque.bottom.store(b + 1, std::memory_order_release);
+    return true;
+}
+
+static void read_slot(const JobSlot &slot, Job &job)
+{
+    job.function = slot.function.load(std::memory_order_relaxed);
+    job.data = slot.data.load(std::memory_order_relaxed);
+    job.counter = slot.counter.load(std::memory_order_relaxed);
+    job.index = slot.index.load(std::memory_order_relaxed);
+}
+
+static bool pop_job(JobDeque &deque, Job &job)
+{
+    const std::int64_t b = deque.bottom.load(std::memory_order_relaxed) - 1;
+    deque.bottom.store(b, std::memory_order_seq_cst);
+    std::int64_t t = deque.top.load(std::memory_order_seq_cst);
+
+    if(t > b) {
+        // The deque was empty
+        deque.bottom.store(b + 1, std::memory_order_relaxed);
+        return false;
+    }
+
+    read_slot(deque.slots[b & DEQUE_MASK], job);
+
+    if(t == b) {
+        // Last job; race thieves for it
+        const bool won = deque.top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+        deque.bottom.store(b + 1, std::memory_order_relaxed);
+        return won;
+    }
+
+    return true;
+}
+
+static bool steal_job(JobDeque &deque, Job &job)
+{
+    std::int64_t t = deque.top.load(std::memory_order_seq_cst);
+    const std::int64_t b = deque.bottom.load(std::memory_order_seq_cst);
+
+    if(t >= b)
+        return false;
+
+    read_slot(deque.slots[t & DEQUE_MASK], job);
+
+    return deque.top.compare_exchange_strong(t, t + 1, std::memory_order_seq_cst, std::memory_order_relaxed);
+}
+
+static void run_job(const Job &job)
+{
+    job.function(job.data, job.index);
+
+    if(job.counter) {
+        job.counter->value.fetch_sub(1, std::memory_order_acq_rel);
+    }
+}
+
+static bool find_job(Job &job)
+{
+    if(local_deque && pop_job(*local_deque, job)) {
+        num_queued.fetch_sub(1, std::memory_order_relaxed);
+        return true;
+    }
+
+    if(num_injected.load(std::memory_order_acquire)) {
+        std::lock_guard<std::mutex> lock(inject_mutex);
+
+        if(!inject_queue.empty()) {
+            job = inject_queue.front();
+            inject_queue.pop_front();
+            num_injected.fetch_sub(1, std::memory_order_relaxed);
+            num_queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    // Start from the neighbouring deque so that
+    // thieves don't all pile onto the same victim
+    const std::size_t count = deques.size();
+
+    for(std::size_t i = 1; i < count; ++i) {
+        auto &victim = *deques[(local_index + i) % count];
+
+        if(steal_job(victim, job)) {
+            num_queued.fetch_sub(1, std::memory_order_relaxed);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+static void wake_workers(std::size_t count)
+{
+    if(num_sleeping.load(std::memory_order_seq_cst)) {
+        // Taking the lock makes sure a worker that is about
+        // to sleep either sees the new job or gets notified
+        { std::lock_guard<std::mutex> lock(sleep_mutex); }
+
+        if(count > 1)
+            sleep_cv.notify_all();
+        else sleep_cv.notify_one();
+    }
+}
+
+static void worker_main(std::size_t index)
+{
+    local_deque = deques[index].get();
+    local_index = index;
+
+    profiler::set_thread_name(("worker " + std::to_string(index)).c_str());
+
+    Job job;
+    unsigned int idle_spins = 0U;
+
+    while(true) {
+        if(find_job(job)) {
+            run_job(job);
+            idle_spins = 0U;
+            continue;
+        }
+
+        if(shutdown.load(std::memory_order_acquire))
+            break;
+
+        if(idle_spins < IDLE_SPINS) {
+            std::this_thread::yield();
+            idle_spins += 1U;
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        num_sleeping.fetch_add(1, std::memory_order_seq_cst);
+        sleep_cv.wait(lock, [](void) {
+            return shutdown.load(std::memory_order_acquire) || num_queued.load(std::memory_order_seq_cst);
+        });
+        num_sleeping.fetch_sub(1, std::memory_order_relaxed);
+        idle_spins = 0U;
+    }
+}
+
+void jobs::init(void)
+{
+    num_workers_config = config::add<int>("jobs.num_workers", -1);
+}
+
+void jobs::init_late(void)
+{
+    int count = config::get(num_workers_config);
+
+    if(cmdline::contains("jobs")) {
+        count = static_cast<int>(std::strtol(cmdline::get("jobs", "-1"), nullptr, 10));
+    }
+
+    if(count < 0) {
+        const unsigned int concurrency = std::thread::hardware_concurrency();
+        count = (concurrency > 1U) ? static_cast<int>(concurrency - 1U) : 0;
+    }
+
+    const unsigned int num_workers = std::min(static_cast<unsigned int>(count), MAX_WORKERS);
+
+    shutdown.store(false, std::memory_order_relaxed);
+
+    for(unsigned int i = 0U; i <= num_workers; ++i) {
+        auto deque = std::make_unique<JobDeque>();
+        deque->top.store(0, std::memory_order_relaxed);
+        deque->bottom.store(0, std::memory_order_relaxed);
+        deques.push_back(std::move(deque));
+    }
+
+    local_deque = deques[0].get();
+    local_index = 0;
+
+    // Deques must all exist before any worker starts stealing
+    for(unsigned int i = 1U; i <= num_workers; ++i) {
+        workers.emplace_back(&worker_main, i);
+    }
+
+    QF_verbose("jobs: %u worker threads", num_workers);
+}
+
+void jobs::deinit(void)
+{
+    Job job;
+
+    while(find_job(job)) {
+        run_job(job);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        shutdown.store(true, std::memory_order_release);
+    }
+
+    sleep_cv.notify_all();
+
+    for(auto &worker : workers)
+        worker.join();
+
+    local_deque = nullptr;
+    local_index = 0;
+
+    workers.clear();
+    deques.clear();
+}
+
+void jobs::submit(QF_JobFunction function, void *data, JobCounter *counter, std::size_t index)
+{
+    const Job job = { function, data, counter, index };
+
+    if(counter) {
+        counter->value.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    if(deques.size() <= 1) {
+        run_job(job);
+        return;
+    }
+
+    if(local_deque == nullptr) {
+        std::lock_guard<std::mutex> lock(inject_mutex);
+        inject_queue.push_back(job);
+        num_injected.fetch_add(1, std::memory_order_release);
+    }
+    else if(!push_job(*local_deque, job)) {
+        run_job(job);
+        return;
+    }
+
+    num_queued.fetch_add(1, std::memory_order_seq_cst);
+    wake_workers(1);
+}
+
+void jobs::submit_batch(QF_JobFunction function, void *data, std::size_t count, JobCounter *counter)
+{
+    if(local_deque == nullptr) {
+        for(std::size_t i = 0; i < count; ++i)
+            jobs::submit(function, data, counter, i);
+        return;
+    }
+
+    if(counter) {
+        counter->value.fetch_add(count, std::memory_order_relaxed);
+    }
+
+    std::size_t num_pushed = 0;
+
+    for(std::size_t i = 0; i < count; ++i) {
+        const Job job = { function, data, counter, i };
+
+        if((deques.size() > 1) && push_job(*local_deque, job)) {
+            num_queued.fetch_add(1, std::memory_order_seq_cst);
+            num_pushed += 1;
+
+            // Get the workers going while the
+            // rest of the batch is being queued
+            if(num_pushed == 1)
+                wake_workers(1);
+            continue;
+        }
+
+        run_job(job);
+    }
+
+    if(num_pushed > 1) {
+        wake_workers(num_pushed);
+    }
+}
+
+void jobs::wait(const JobCounter &counter)
+{
+    Job job;
+
+    while(counter.value.load(std::memory_order_acquire)) {
+        if(find_job(job)) {
+            run_job(job);
+            continue;
+        }
+
+        std::this_thread::yield();
+    }
+}
+
+unsigned int jobs::num_workers(void)
+{
+    return static_cast<unsigned int>(workers.size());
+}
@@ -0,0 +1,80 @@
+#ifndef CORE_JOBS_HH
+#define CORE_JOBS_HH 1
+#pragma once
+
+/**
+ * A job entry point
+ * @param data Opaque pointer passed to jobs::submit
+ * @param index Job index within a batch; zero for single jobs
+ */
+using QF_JobFunction = void(*)(void *data, std::size_t index);
+
+/**
+ * Counts jobs that haven't finished yet; used
+ * to join a group of jobs with jobs::wait
+ * @note Must outlive all the jobs it was submitted with
+ */
+struct JobCounter final {
+    std::atomic<std::size_t> value = 0;
+};
+
+namespace jobs
+{
+/**
+ * Registers job system config variables
+ */
+void init(void);
+
+/**
+ * Spawns worker threads; should be called from the main
+ * thread after the config files are loaded. Worker count
+ * comes from the `-jobs` command line option if present
+ * and from the `jobs.num_workers` config variable otherwise;
+ * a negative value means one less than hardware concurrency
+ */
+void init_late(void);
+
+/**
+ * Finishes all queued jobs and joins the workers
+ */
+void deinit(void);
+} // namespace jobs
+
+namespace jobs
+{
+/**
+ * Queues a job on the calling thread's deque; idle
+ * workers steal it from there. Threads that don't belong
+ * to the pool queue into a shared list instead. Without
+ * any workers or when the deque is full the job runs immediately
+ * @param function Job entry point
+ * @param data Opaque pointer passed to the job
+ * @param counter Incremented now and decremented once the job is done
+ * @param index Passed to the job
+ */
+void submit(QF_JobFunction function, void *data, JobCounter *counter = nullptr, std::size_t index = 0);
+
+/**
+ * Queues `count` jobs with indices [0, count)
+ * @param function Job entry point
+ * @param data Opaque pointer passed to every job
+ * @param count Amount of jobs
+ * @param counter Incremented now and decremented as jobs finish
+ */
+void submit_batch(QF_JobFunction function, void *data, std::size_t count, JobCounter *counter);
+
+/**
+ * Runs queued jobs on the calling thread
+ * until the counter reaches zero
+ * @param counter Counter the jobs were submitted with
+ */
+void wait(const JobCounter &counter);
+
+/**
+ * Get the amount of worker threads
+ * @returns Worker count, not including the main thread
+ */
+unsigned int num_workers(void);
+} // namespace jobs
+
+#endif /* CORE_JOBS_HH */
@@ -2,10 +2,389 @@
 #include "core/logging.hh"
 
 #include "core/cmdline.hh"
+#include "core/constexpr.hh"
+#include "core/memtrack.hh"
 
-static QF_LogFunction log_callback = nullptr;
-static QF_LogLevel log_level = DEFAULT_LOG_LEVEL;
-static std::mutex log_mutex;
+// Both must be powers of two; records longer
+// than LOG_RECORD_SIZE are truncated
+constexpr static std::size_t LOG_QUEUE_SIZE = 512;
+constexpr static std::size_t LOG_RECORD_SIZE = 1024;
+
+// How long the logger thread sleeps when there's
+// nothing to do; producers only poke it when it's asleep
+constexpr static auto LOG_IDLE_TIMEOUT = std::chrono::milliseconds(5);
+
+// Deferred records store captured arguments at the start of
+// the string buffer followed by copies of string arguments
+constexpr static std::size_t LOG_MAX_ARGUMENTS = LOG_RECORD_SIZE / sizeof(QF_LogArgument) / 2;
+
+struct alignas(64) LogRecord final {
+    std::atomic<std::size_t> sequence;
+    QF_LogLevel level;
+    std::size_t size;
+    const char *format;
+    std::size_t num_args;
+    char string[LOG_RECORD_SIZE];
+};
+
+static std::atomic<QF_LogFunction> log_callback = nullptr;
+static std::atomic<QF_LogLevel> log_level = DEFAULT_LOG_LEVEL;
+static std::atomic<QF_LogPolicy> log_policy = QF_LOG_BLOCK;
+static std::atomic<bool> log_deferred = false;
+
+// Bounded MPSC queue; each slot carries a sequence number
+// that tells producers and the consumer whose turn it is
+// @see Dmitry Vyukov's [bounded MPMC queue](https://www.1024cores.net/home/lock-free-algorithms/queues/bounded-mpmc-queue)
+static LogRecord log_queue[LOG_QUEUE_SIZE];
+alignas(64) static std::atomic<std::size_t> enqueue_position;
+alignas(64) static std::atomic<std::size_t> dequeue_position;
+alignas(64) static std::atomic<std::size_t> dropped_count;
+
+static std::atomic<bool> thread_running = false;
+static std::atomic<bool> queue_accepting = false;
+static std::atomic<std::size_t> num_producers = 0;
+static std::atomic<bool> thread_sleeping = false;
+static std::atomic_flag consumer_busy = ATOMIC_FLAG_INIT;
+static std::condition_variable thread_wakeup;
+static std::mutex thread_wakeup_mutex;
+static std::thread logger_thread;
+
+static std::terminate_handler previous_terminate = nullptr;
+
+static std::int64_t argument_signed(const QF_LogArgument *arg)
+{
+    if(arg == nullptr)
+        return INT64_C(0);
+    if(arg->type == QF_LogArgument::DOUBLE)
+        return static_cast<std::int64_t>(arg->f);
+    return arg->i;
+}
+
+static double argument_double(const QF_LogArgument *arg)
+{
+    if(arg == nullptr)
+        return 0.0;
+    if(arg->type == QF_LogArgument::SIGNED)
+        return static_cast<double>(arg->i);
+    if(arg->type == QF_LogArgument::UNSIGNED)
+        return static_cast<double>(arg->u);
+    if(arg->type == QF_LogArgument::DOUBLE)
+        return arg->f;
+    return 0.0;
+}
+
+// Formats a message from captured arguments one conversion at a
+// time; length modifiers are rewritten to match the captured types
+static std::size_t format_deferred(char *buffer, std::size_t size, const char *format, const QF_LogArgument *args, std::size_t num_args)
+{
+    std::size_t length = 0;
+    std::size_t next_arg = 0;
+
+    const auto next = [&](void) -> const QF_LogArgument * {
+        if(next_arg < num_args)
+            return &args[next_arg++];
+        return nullptr;
+    };
+
+    const auto emit = [&](const char *spec, const int *stars, int num_stars, auto value) {
+        if(length + 1 >= size)
+            return;
+
+        const auto space = static_cast<int>(size - length);
+        int count = 0;
+
+        if(num_stars == 0)
+            count = stbsp_snprintf(buffer + length, space, spec, value);
+        else if(num_stars == 1)
+            count = stbsp_snprintf(buffer + length, space, spec, stars[0], value);
+        else count = stbsp_snprintf(buffer + length, space, spec, stars[0], stars[1], value);
+
+        length += std::min<std::size_t>(static_cast<std::size_t>(cxpr::max(count, 0)), size - length - 1);
+    };
+
+    while(*format && (length + 1) < size) {
+        if(format[0] != '%') {
+            buffer[length++] = *format++;
+            continue;
+        }
+
+        if(format[1] == '%') {
+            buffer[length++] = '%';
+            format += 2;
+            continue;
+        }
+
+        char spec[32];
+        std::size_t spec_size = 0;
+        int stars[2];
+        int num_stars = 0;
+
+        spec[spec_size++] = *format++;
+
+        while(*format && std::strchr("-+ #0'$_", *format) && (spec_size < 16))
+            spec[spec_size++] = *format++;
+
+        if(*format == '*') {
+            stars[num_stars++] = static_cast<int>(argument_signed(next()));
+            spec[spec_size++] = *format++;
+        }
+        else while(std::isdigit(static_cast<unsigned char>(*format)) && (spec_size < 20)) {
+            spec[spec_size++] = *format++;
+        }
+
+        if(*format == '.') {
+            spec[spec_size++] = *format++;
+
+            if(*format == '*') {
+                stars[num_stars++] = static_cast<int>(argument_signed(next()));
+                spec[spec_size++] = *format++;
+            }
+            else while(std::isdigit(static_cast<unsigned char>(*format)) && (spec_size < 26)) {
+                spec[spec_size++] = *format++;
+            }
+        }
+
+        // Captured values are always 64-bit so
+        // the original length modifier is irrelevant
+        while(*format && std::strchr("hlzjtLqI", *format))
+            format += 1;
+
+        const char conversion = *format;
+
+        if(conversion == 0)
+            break;
+        format += 1;
+
+        switch(conversion) {
+            case 'd': case 'i':
+            case 'u': case 'o': case 'x': case 'X':
+                spec[spec_size++] = 'l';
+                spec[spec_size++] = 'l';
+                spec[spec_size++] = conversion;
+                spec[spec_size] = 0;
+                emit(spec, stars, num_stars, static_cast<long long>(argument_signed(next())));
+                break;
+            case 'c':
+                spec[spec_size++] = conversion;
+                spec[spec_size] = 0;
+                emit(spec, stars, num_stars, static_cast<int>(argument_signed(next())));
+                break;
+            case 'f': case 'F': case 'e': case 'E':
+            case 'g': case 'G': case 'a': case 'A':
+                spec[spec_size++] = conversion;
+                spec[spec_size] = 0;
+                emit(spec, stars, num_stars, argument_double(next()));
+                break;
+            case 's':
+                spec[spec_size++] = conversion;
+                spec[spec_size] = 0;
+                if(auto arg = next(); arg && (arg->type == QF_LogArgument::STRING) && arg->s)
+                    emit(spec, stars, num_stars, arg->s);
+                else emit(spec, stars, num_stars, "(null)");
+                break;
+            case 'p':
+                spec[spec_size++] = conversion;
+                spec[spec_size] = 0;
+                if(auto arg = next())
+                    emit(spec, stars, num_stars, arg->p);
+                else emit(spec, stars, num_stars, static_cast<const void *>(nullptr));
+                break;
+            default:
+                next();
+                break;
+        }
+    }
+
+    buffer[length] = 0;
+    return length;
+}
+
+static void invoke_callback(QF_LogLevel level, const char *string, std::size_t size)
+{
+    if(auto callback = log_callback.load(std::memory_order_acquire))
+        callback(level, string, size);
+    else logging::default_callback(level, string, size);
+}
+
+// The callback is never called concurrently; every path
+// that calls it, including printing messages synchronously
+// while the logger thread is not running, holds consumer_busy
+static void lock_consumer(void)
+{
+    while(consumer_busy.test_and_set(std::memory_order_acquire)) {
+        std::this_thread::yield();
+    }
+}
+
+static void unlock_consumer(void)
+{
+    consumer_busy.clear(std::memory_order_release);
+}
+
+static void print_now(QF_LogLevel level, const char *string, std::size_t size)
+{
+    lock_consumer();
+    invoke_callback(level, string, size);
+    unlock_consumer();
+}
+
+// Consumes everything that has been published so far;
+// only one thread at a time may do this (see consumer_busy)
+static bool drain_queue(void)
+{
+    bool drained_any = false;
+    std::size_t position = dequeue_position.load(std::memory_order_relaxed);
+
+    while(true) {
+        auto &record = log_queue[position & (LOG_QUEUE_SIZE - 1)];
+
+        if(record.sequence.load(std::memory_order_acquire) != (position + 1))
+            break;
+
+        if(record.format) {
+            QF_LogArgument args[LOG_MAX_ARGUMENTS];
+            std::memcpy(args, record.string, record.num_args * sizeof(QF_LogArgument));
+
+            for(std::size_t i = 0; i < record.num_args; ++i) {
+                if(args[i].type == QF_LogArgument::STRING)
+                    args[i].s = (args[i].u < LOG_RECORD_SIZE) ? (record.string + args[i].u) : nullptr;
+            }
+
+            char string[LOG_RECORD_SIZE];
+            auto size = format_deferred(string, sizeof(string), record.format, args, record.num_args);
+            invoke_callback(record.level, string, size);
+        }
+        else {
+            invoke_callback(record.level, record.string, record.size);
+        }
+
+        record.sequence.store(position + LOG_QUEUE_SIZE, std::memory_order_release);
+        dequeue_position.store(++position, std::memory_order_release);
+        drained_any = true;
+    }
+
+    if(auto dropped = dropped_count.exchange(0, std::memory_order_relaxed)) {
+        char string[64];
+        auto size = stbsp_snprintf(string, sizeof(string), "logging: dropped %zu messages", dropped);
+        invoke_callback(QF_WARNING, string, static_cast<std::size_t>(size));
+    }
+
+    return drained_any;
+}
+
+static void logger_main(void)
+{
+    while(thread_running.load(std::memory_order_acquire)) {
+        lock_consumer();
+        const bool drained_any = drain_queue();
+        unlock_consumer();
+
+        if(!drained_any) {
+            thread_sleeping.store(true);
+            std::unique_lock<std::mutex> lock(thread_wakeup_mutex);
+            thread_wakeup.wait_for(lock, LOG_IDLE_TIMEOUT);
+            thread_sleeping.store(false);
+        }
+    }
+}
+
+static void on_terminate(void)
+{
+    logging::flush_on_crash();
+
+    if(previous_terminate)
+        previous_terminate();
+    std::abort();
+}
+
+static void on_crash_signal(int signum)
+{
+    // This is best-effort: the callback is hardly
+    // async-signal-safe, but we're going down anyway
+    logging::flush_on_crash();
+    std::signal(signum, SIG_DFL);
+    std::raise(signum);
+}
+
+// Producers announce themselves before checking whether the
+// queue accepts records; logging::deinit clears the flag after
+// joining the logger thread and then waits for the announced
+// ones, so every queued record is published before the final drain
+static bool enter_producer(void)
+{
+    num_producers.fetch_add(1);
+
+    if(queue_accepting.load())
+        return true;
+
+    num_producers.fetch_sub(1, std::memory_order_release);
+    return false;
+}
+
+static void leave_producer(void)
+{
+    num_producers.fetch_sub(1, std::memory_order_release);
+}
+
+// Claims the next queue slot or returns nullptr
+// if the queue is full and the policy says to drop
+static LogRecord *reserve_record(std::size_t &position)
+{
+    position = enqueue_position.load(std::memory_order_relaxed);
+
+    while(true) {
+        auto record = &log_queue[position & (LOG_QUEUE_SIZE - 1)];
+        auto sequence = record->sequence.load(std::memory_order_acquire);
+        auto difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+
+        if(difference == 0) {
+            if(enqueue_position.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+                return record;
+            continue;
+        }
+
+        if(difference < 0) {
+            // The queue is full; once the logger thread
+            // is gone, producers have to make room themselves
+            if(!thread_running.load(std::memory_order_acquire)) {
+                if(!consumer_busy.test_and_set(std::memory_order_acquire)) {
+                    drain_queue();
+                    unlock_consumer();
+                }
+
+                std::this_thread::yield();
+                position = enqueue_position.load(std::memory_order_relaxed);
+                continue;
+            }
+
+            if(log_policy.load(std::memory_order_relaxed) == QF_LOG_DROP) {
+                dropped_count.fetch_add(1, std::memory_order_relaxed);
+                return nullptr;
+            }
+
+            thread_wakeup.notify_one();
+            std::this_thread::yield();
+        }
+
+        position = enqueue_position.load(std::memory_order_relaxed);
+    }
+}
+
+static void publish_record(LogRecord *record, std::size_t position)
+{
+    record->sequence.store(position + 1, std::memory_order_release);
+
+    if(thread_sleeping.load()) {
+        thread_wakeup.notify_one();
+    }
+}
+
+static void print_deferred_now(QF_LogLevel level, const char *format, const QF_LogArgument *args, std::size_t num_args)
+{
+    char string[LOG_RECORD_SIZE];
+    auto size = format_deferred(string, sizeof(string), format, args, num_args);
+    print_now(level, string, size);
+}
 
 void logging::default_callback(QF_LogLevel level, const char *string, std::size_t size)
 {
@@ -21,20 +400,44 @@ void logging::default_callback(QF_LogLevel level, const char *string, std::size_
 
 void logging::set_callback(QF_LogFunction callback)
 {
-    log_mutex.lock();
-    log_callback = callback;
-    log_mutex.unlock();
+    log_callback.store(callback, std::memory_order_release);
 }
 
 void logging::set_level(QF_LogLevel level)
 {
-    log_mutex.lock();
-    log_level = level;
-    log_mutex.unlock();
+    log_level.store(level, std::memory_order_relaxed);
+}
+
+void logging::set_policy(QF_LogPolicy policy)
+{
+    log_policy.store(policy, std::memory_order_relaxed);
+}
+
+void logging::set_deferred(bool enable)
+{
+    log_deferred.store(enable, std::memory_order_relaxed);
+}
+
+QF_LogLevel logging::get_level(void)
+{
+    return log_level.load(std::memory_order_relaxed);
+}
+
+bool logging::is_deferred(void)
+{
+    return log_deferred.load(std::memory_order_relaxed);
 }
 
 void logging::init_from_cmdline(void)
 {
+    if(cmdline::contains("log-drop")) {
+        logging::set_policy(QF_LOG_DROP);
+    }
+
+    if(cmdline::contains("log-deferred")) {
+        logging::set_deferred(true);
+    }
+
     if(cmdline::contains("quiet")) {
         logging::set_level(QF_SILENT);
         return;
@@ -46,9 +449,90 @@ void logging::init_from_cmdline(void)
     }
 }
 
+void logging::init(void)
+{
+    QF_memory_tag(MEMTAG_LOGGING);
+
+    if(thread_running.load())
+        return;
+
+    for(std::size_t i = 0; i < LOG_QUEUE_SIZE; ++i)
+        log_queue[i].sequence.store(i, std::memory_order_relaxed);
+    enqueue_position.store(0, std::memory_order_relaxed);
+    dequeue_position.store(0, std::memory_order_relaxed);
+    dropped_count.store(0, std::memory_order_relaxed);
+
+    thread_running.store(true, std::memory_order_release);
+    queue_accepting.store(true);
+    logger_thread = std::thread(&logger_main);
+
+    previous_terminate = std::set_terminate(&on_terminate);
+    std::signal(SIGSEGV, &on_crash_signal);
+    std::signal(SIGABRT, &on_crash_signal);
+    std::signal(SIGFPE, &on_crash_signal);
+    std::signal(SIGILL, &on_crash_signal);
+}
+
+void logging::deinit(void)
+{
+    if(!thread_running.exchange(false))
+        return;
+
+    thread_wakeup.notify_one();
+    logger_thread.join();
+
+    // Messages keep going into the queue until the thread
+    // is gone so they stay in order; later ones are printed
+    // synchronously, which waits for the queue to be drained
+    lock_consumer();
+    queue_accepting.store(false);
+
+    // Producers that got in may still be filling
+    // their records in or waiting for room in the queue
+    while(num_producers.load(std::memory_order_acquire)) {
+        drain_queue();
+        std::this_thread::yield();
+    }
+
+    drain_queue();
+    unlock_consumer();
+
+    std::set_terminate(previous_terminate);
+    std::signal(SIGSEGV, SIG_DFL);
+    std::signal(SIGABRT, SIG_DFL);
+    std::signal(SIGFPE, SIG_DFL);
+    std::signal(SIGILL, SIG_DFL);
+}
+
+void logging::flush(void)
+{
+    if(thread_running.load(std::memory_order_acquire)) {
+        const std::size_t target = enqueue_position.load(std::memory_order_acquire);
+
+        while(dequeue_position.load(std::memory_order_acquire) < target) {
+            thread_wakeup.notify_one();
+            std::this_thread::yield();
+        }
+    }
+}
+
+void logging::flush_on_crash(void)
+{
+    // Give whoever is draining the queue a moment to
+    // let go of it; if it's the one crashing, just barge in
+    for(int attempt = 0; attempt < 1000; ++attempt) {
+        if(!consumer_busy.test_and_set(std::memory_order_acquire))
+            break;
+        std::this_thread::yield();
+    }
+
+    drain_queue();
+    unlock_consumer();
+}
+
 void logging::printf(QF_LogLevel level, const char *format, ...)
 {
-    if(level >= log_level) {
+    if(level >= log_level.load(std::memory_order_relaxed)) {
         std::va_list va;
         va_start(va, format);
         logging::vprintf(level, format, va);
@@ -58,20 +542,92 @@ void logging::printf(QF_LogLevel level, const char *format, ...)
 
 void logging::vprintf(QF_LogLevel level, const char *format, std::va_list va)
 {
-    if(level >= log_level) {
-        auto count = stbsp_vsnprintf(nullptr, 0, format, va);
-        auto string = std::string(std::size_t(count + 2), char(0x00));
-        stbsp_vsnprintf(string.data(), string.size(), format, va);
+    if(level < log_level.load(std::memory_order_relaxed))
+        return;
 
-        if(log_callback == nullptr) {
-            log_mutex.lock();
-            logging::default_callback(level, string.c_str(), string.size());
-            log_mutex.unlock();
-        }
-        else {
-            log_mutex.lock();
-            log_callback(level, string.c_str(), string.size());
-            log_mutex.unlock();
+    if(!enter_producer()) {
+        char string[LOG_RECORD_SIZE];
+        auto count = stbsp_vsnprintf(string, sizeof(string), format, va);
+        print_now(level, string, std::min<std::size_t>(count, sizeof(string) - 1));
+        return;
+    }
+
+    std::size_t position;
+    LogRecord *record = reserve_record(position);
+
+    if(record == nullptr) {
+        // The queue is full and the policy says to drop
+        leave_producer();
+        return;
+    }
+
+    auto count = stbsp_vsnprintf(record->string, sizeof(record->string), format, va);
+    record->level = level;
+    record->size = std::min<std::size_t>(count, sizeof(record->string) - 1);
+    record->format = nullptr;
+    record->num_args = 0;
+    publish_record(record, position);
+    leave_producer();
+}
+
+void logging::print_deferred(QF_LogLevel level, const char *format, const QF_LogArgument *args, std::size_t num_args)
+{
+    if(level < log_level.load(std::memory_order_relaxed))
+        return;
+
+    if(!enter_producer()) {
+        print_deferred_now(level, format, args, num_args);
+        return;
+    }
+
+    std::size_t position;
+    LogRecord *record = reserve_record(position);
+
+    if(record == nullptr) {
+        // The queue is full and the policy says to drop
+        leave_producer();
+        return;
+    }
+
+    if(num_args > LOG_MAX_ARGUMENTS) {
+        // Too many arguments to capture; format the
+        // message right away and queue the text instead
+        record->level = level;
+        record->size = format_deferred(record->string, sizeof(record->string), format, args, num_args);
+        record->format = nullptr;
+        record->num_args = 0;
+        publish_record(record, position);
+        leave_producer();
+        return;
+    }
+
+    // Strings can't be captured by pointer because they
+    // may be gone by the time the logger thread gets to them
+    std::size_t offset = num_args * sizeof(QF_LogArgument);
+
+    for(std::size_t i = 0; i < num_args; ++i) {
+        QF_LogArgument arg = args[i];
+
+        if(arg.type == QF_LogArgument::STRING) {
+            if(arg.s && (offset < LOG_RECORD_SIZE)) {
+                const std::size_t length = std::min(std::strlen(arg.s), LOG_RECORD_SIZE - offset - 1);
+                std::memcpy(record->string + offset, arg.s, length);
+                record->string[offset + length] = 0;
+                arg.u = offset;
+                offset += length + 1;
+            }
+            else {
+                arg.u = LOG_RECORD_SIZE;
+            }
         }
+
+        std::memcpy(record->string + i * sizeof(QF_LogArgument), &arg, sizeof(QF_LogArgument));
     }
+
+    record->level = level;
+    record->size = 0;
+    record->format = format;
+    record->num_args = num_args;
+    publish_record(record, position);
+    leave_producer();
 }
@@ -21,13 +21,22 @@ constexpr static QF_LogLevel DEFAULT_LOG_LEVEL = QF_INFORM;
 constexpr static QF_LogLevel DEFAULT_LOG_LEVEL = QF_VERBOSE;
 #endif
 
+/**
+ * What to do when the logging queue is full
+ */
+enum QF_LogPolicy : unsigned int {
+    QF_LOG_BLOCK    = 0x0000, ///< Wait for the logger thread to catch up
+    QF_LOG_DROP     = 0x0001, ///< Discard the message and report the count later
+};
+
 /**
  * A message callback function pointer
  * @param level Message priority associated with the message
  * @param string Zero-terminated message string
  * @param size Length of the message
- * @note Whenever this function is called, it is guaranteed to be wrapped around
- * a mutex and is guaranteed to have passed all the internal log level checks
+ * @note Whenever this function is called, it is guaranteed to never be called
+ * concurrently (normally it runs on the logger thread) and is guaranteed
+ * to have passed all the internal log level checks
  */
 using QF_LogFunction = void(*)(QF_LogLevel level, const char *string, std::size_t size);
 
@@ -54,6 +63,12 @@ void set_callback(QF_LogFunction callback);
  */
 void set_level(QF_LogLevel level);
 
+/**
+ * Set the queue overflow policy
+ * @param policy Overflow policy
+ */
+void set_policy(QF_LogPolicy policy);
+
 /**
  * Sets up the logger with a level that may
  * have been passed into the command line;
@@ -61,6 +76,82 @@ void set_level(QF_LogLevel level);
 void init_from_cmdline(void);
 } // namespace logging
 
+namespace logging
+{
+/**
+ * Starts the logger thread; until this is called and
+ * after logging::deinit messages are printed synchronously
+ * @note This also installs terminate and crash signal handlers
+ * that call logging::flush_on_crash before the process dies
+ */
+void init(void);
+
+/**
+ * Stops the logger thread after it prints everything queued
+ */
+void deinit(void);
+
+/**
+ * Waits until every message queued so
+ * far has been passed to the callback
+ */
+void flush(void);
+
+/**
+ * Prints every message queued so far from the calling thread
+ * @note This is meant to be called when the process is about to die
+ */
+void flush_on_crash(void);
+} // namespace logging
+
+/**
+ * A captured argument of a deferred log message
+ */
+struct QF_LogArgument final {
+    enum Type : unsigned int {
+        SIGNED,
+        UNSIGNED,
+        DOUBLE,
+        STRING,
+        POINTER,
+    } type;
+
+    union {
+        std::int64_t i;
+        std::uint64_t u;
+        double f;
+        const char *s;
+        const void *p;
+    };
+};
+
+namespace logging
+{
+/**
+ * Enables or disables deferred formatting; when enabled,
+ * the logging macros only capture the format string pointer
+ * and raw argument values and the actual formatting is done
+ * by the logger thread instead of the calling thread
+ * @param enable Whether to defer formatting
+ * @note Format strings must have static storage duration
+ * (i.e. be string literals) for this to work; string
+ * arguments are copied into the log record
+ */
+void set_deferred(bool enable);
+
+/**
+ * Figure out the current logging level
+ * @returns Log level
+ */
+QF_LogLevel get_level(void);
+
+/**
+ * Checks if deferred formatting is enabled
+ * @returns true if logging::set_deferred(true) was called
+ */
+bool is_deferred(void);
+} // namespace logging
+
 namespace logging
 {
 /**
@@ -79,43 +170,120 @@ void printf(QF_LogLevel level, const char *format, ...);
  * @see cppreference for [vfprintf](https://en.cppreference.com/w/c/io/vfprintf)
  */
 void vprintf(QF_LogLevel level, const char *format, std::va_list va);
+
+/**
+ * Queue a message with captured arguments
+ * @param level Log level
+ * @param format Format string in sprintf style; must be a string literal
+ * @param args Captured arguments
+ * @param num_args Amount of captured arguments
+ * @note Messages with more arguments than a queue record can hold
+ * are formatted on the calling thread and queued as plain text
+ */
+void print_deferred(QF_LogLevel level, const char *format, const QF_LogArgument *args, std::size_t num_args);
+
+/**
+ * Print a message, deferring formatting to
+ * the logger thread if deferred mode is enabled
+ * @param level Log level
+ * @param format Format string in sprintf style; must be a string literal
+ * @param args Format arguments
+ */
+template<typename... A>
+static inline void print(QF_LogLevel level, const char *format, const A &... args);
+} // namespace logging
+
+namespace logging
+{
+template<typename T>
+static inline QF_LogArgument capture(const T &value)
+{
+    QF_LogArgument result;
+
+    if constexpr(std::is_enum_v<T>) {
+        return logging::capture(static_cast<std::underlying_type_t<T>>(value));
+    }
+    else if constexpr(std::is_floating_point_v<T>) {
+        result.type = QF_LogArgument::DOUBLE;
+        result.f = static_cast<double>(value);
+    }
+    else if constexpr(std::is_integral_v<T> && std::is_signed_v<T>) {
+        result.type = QF_LogArgument::SIGNED;
+        result.i = static_cast<std::int64_t>(value);
+    }
+    else if constexpr(std::is_integral_v<T>) {
+        result.type = QF_LogArgument::UNSIGNED;
+        result.u = static_cast<std::uint64_t>(value);
+    }
+    else if constexpr(std::is_convertible_v<T, const char *>) {
+        result.type = QF_LogArgument::STRING;
+        result.s = value;
+    }
+    else {
+        static_assert(std::is_pointer_v<T>, "unsupported log argument type");
+        result.type = QF_LogArgument::POINTER;
+        result.p = value;
+    }
+
+    return result;
+}
 } // namespace logging
 
+template<typename... A>
+static inline void logging::print(QF_LogLevel level, const char *format, const A &... args)
+{
+    if(level < logging::get_level())
+        return;
+
+    if(!logging::is_deferred()) {
+        logging::printf(level, format, args...);
+        return;
+    }
+
+    if constexpr(sizeof...(A) == 0) {
+        logging::print_deferred(level, format, nullptr, 0);
+    }
+    else {
+        const QF_LogArgument captured[] = { logging::capture(args)... };
+        logging::print_deferred(level, format, captured, sizeof...(A));
+    }
+}
+
 /**
  * Print a formatted message with `QF_VERBOSE` level
  * @param format Format string in sprintf style
  */
-#define QF_verbose(format, ...) logging::printf(QF_VERBOSE, (format), ##__VA_ARGS__)
+#define QF_verbose(format, ...) logging::print(QF_VERBOSE, (format), ##__VA_ARGS__)
 
 /**
  * Print a formatted message with `QF_INFORM` level
  * @param format Format string in sprintf style
  */
-#define QF_inform(format, ...) logging::printf(QF_INFORM, (format), ##__VA_ARGS__)
+#define QF_inform(format, ...) logging::print(QF_INFORM, (format), ##__VA_ARGS__)
 
 /**
  * Print a formatted message with `QF_NOTICE` level
  * @param format Format string in sprintf style
  */
-#define QF_notice(format, ...) logging::printf(QF_NOTICE, (format), ##__VA_ARGS__)
+#define QF_notice(format, ...) logging::print(QF_NOTICE, (format), ##__VA_ARGS__)
 
 /**
  * Print a formatted message with `QF_WARNING` level
  * @param format Format string in sprintf style
  */
-#define QF_warning(format, ...) logging::printf(QF_WARNING, (format), ##__VA_ARGS__)
+#define QF_warning(format, ...) logging::print(QF_WARNING, (format), ##__VA_ARGS__)
 
 /**
  * Print a formatted message with `QF_ERROR` level
  * @param format Format string in sprintf style
  */
-#define QF_error(format, ...) logging::printf(QF_ERROR, (format), ##__VA_ARGS__)
+#define QF_error(format, ...) logging::print(QF_ERROR, (format), ##__VA_ARGS__)
 
 /**
  * Print a formatted message with `QF_EMERG` level
  * @param format Format string in sprintf style
  */
-#define QF_emerg(format, ...) logging::printf(QF_EMERG, (format), ##__VA_ARGS__)
+#define QF_emerg(format, ...) logging::print(QF_EMERG, (format), ##__VA_ARGS__)
 
 /**
  * Print a formatted message with `QF_VERBOSE` level
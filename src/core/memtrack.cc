@@ -0,0 +1,312 @@
+#include "core/precompiled.hh"
+#include "core/memtrack.hh"
+
+#include "core/logging.hh"
+
+// Every tracked allocation is preceded by this; the
+// size and the tag are needed to account for a free
+// and the offset leads back to what malloc returned
+struct alignas(16) MemoryHeader final {
+    std::size_t size;
+    std::uint32_t tag;
+    std::uint32_t offset;
+};
+
+static_assert(sizeof(MemoryHeader) == 16);
+
+struct TagCounters final {
+    std::atomic<std::size_t> num_bytes;
+    std::atomic<std::size_t> num_allocations;
+    std::atomic<std::size_t> peak_bytes;
+    std::atomic<std::size_t> frame_bytes;
+    std::atomic<std::size_t> frame_allocations;
+    std::size_t last_frame_bytes;
+    std::size_t last_frame_allocations;
+};
+
+constexpr static const char *tag_names[MEMTAG_COUNT] = {
+    "general",
+    "config",
+    "logging",
+    "profiler",
+    "registry",
+    "network",
+    "imgui",
+    "physfs",
+    "render",
+};
+
+static TagCounters counters[MEMTAG_COUNT] = {};
+thread_local static QF_MemoryTag current_tag = MEMTAG_GENERAL;
+
+static void *tracked_allocate(std::size_t size, std::size_t alignment, QF_MemoryTag tag)
+{
+    alignment = std::max(alignment, alignof(MemoryHeader));
+
+    const std::size_t padding = alignment - alignof(MemoryHeader);
+    auto base = static_cast<std::byte *>(std::malloc(size + padding + sizeof(MemoryHeader)));
+
+    if(base == nullptr)
+        return nullptr;
+
+    const auto address = reinterpret_cast<std::uintptr_t>(base + sizeof(MemoryHeader));
+    const auto aligned = (address + alignment - 1) & ~static_cast<std::uintptr_t>(alignment - 1);
+    auto pointer = base + sizeof(MemoryHeader) + (aligned - address);
+
+    auto header = reinterpret_cast<MemoryHeader *>(pointer) - 1;
+    header->size = size;
+    header->tag = tag;
+    header->offset = static_cast<std::uint32_t>(pointer - base);
+
+#if ENABLE_MEMTRACK
+    auto &counter = counters[tag];
+    const std::size_t num_bytes = counter.num_bytes.fetch_add(size, std::memory_order_relaxed) + size;
+    counter.num_allocations.fetch_add(1, std::memory_order_relaxed);
+    counter.frame_bytes.fetch_add(size, std::memory_order_relaxed);
+    counter.frame_allocations.fetch_add(1, std::memory_order_relaxed);
+
+    std::size_t peak_bytes = counter.peak_bytes.load(std::memory_order_relaxed);
+    while((num_bytes > peak_bytes) && !counter.peak_bytes.compare_exchange_weak(peak_bytes, num_bytes, std::memory_order_relaxed));
+#endif
+
+    return pointer;
+}
+
+static void tracked_deallocate(void *pointer)
+{
+    if(pointer == nullptr)
+        return;
+
+    auto header = static_cast<MemoryHeader *>(pointer) - 1;
+
+#if ENABLE_MEMTRACK
+    auto &counter = counters[header->tag];
+    counter.num_bytes.fetch_sub(header->size, std::memory_order_relaxed);
+    counter.num_allocations.fetch_sub(1, std::memory_order_relaxed);
+#endif
+
+    std::free(static_cast<std::byte *>(pointer) - header->offset);
+}
+
+#if ENABLE_MEMTRACK
+static std::size_t tracked_size(void *pointer)
+{
+    return (static_cast<MemoryHeader *>(pointer) - 1)->size;
+}
+
+static void *physfs_malloc(PHYSFS_uint64 size)
+{
+    return tracked_allocate(static_cast<std::size_t>(size), alignof(std::max_align_t), MEMTAG_PHYSFS);
+}
+
+static void *physfs_realloc(void *pointer, PHYSFS_uint64 size)
+{
+    if(pointer == nullptr)
+        return physfs_malloc(size);
+
+    auto result = physfs_malloc(size);
+
+    if(result) {
+        std::memcpy(result, pointer, std::min(tracked_size(pointer), static_cast<std::size_t>(size)));
+        tracked_deallocate(pointer);
+    }
+
+    return result;
+}
+
+static void physfs_free(void *pointer)
+{
+    tracked_deallocate(pointer);
+}
+#endif
+
+MemoryTagScope::MemoryTagScope(QF_MemoryTag tag) : previous_tag(current_tag)
+{
+    current_tag = tag;
+}
+
+MemoryTagScope::~MemoryTagScope(void)
+{
+    current_tag = previous_tag;
+}
+
+void memtrack::init(void)
+{
+#if ENABLE_MEMTRACK
+    PHYSFS_Allocator allocator = {};
+    allocator.Malloc = &physfs_malloc;
+    allocator.Realloc = &physfs_realloc;
+    allocator.Free = &physfs_free;
+    PHYSFS_setAllocator(&allocator);
+#endif
+}
+
+void memtrack::report_leaks(void)
+{
+#if ENABLE_MEMTRACK
+    for(unsigned int i = 0; i < MEMTAG_COUNT; ++i) {
+        const auto num_bytes = counters[i].num_bytes.load(std::memory_order_relaxed);
+        const auto num_allocations = counters[i].num_allocations.load(std::memory_order_relaxed);
+
+        if(num_allocations) {
+            QF_inform("memtrack: %s: %zu bytes in %zu allocations still live", tag_names[i], num_bytes, num_allocations);
+        }
+    }
+#endif
+}
+
+void memtrack::update_frame(void)
+{
+    for(auto &counter : counters) {
+        counter.last_frame_bytes = counter.frame_bytes.exchange(0, std::memory_order_relaxed);
+        counter.last_frame_allocations = counter.frame_allocations.exchange(0, std::memory_order_relaxed);
+    }
+}
+
+void *memtrack::allocate(std::size_t size, std::size_t alignment, QF_MemoryTag tag)
+{
+    return tracked_allocate(size, alignment, tag);
+}
+
+void memtrack::deallocate(void *pointer)
+{
+    tracked_deallocate(pointer);
+}
+
+MemoryStats memtrack::get_stats(QF_MemoryTag tag)
+{
+    MemoryStats result = {};
+
+    if(tag < MEMTAG_COUNT) {
+        result.num_bytes = counters[tag].num_bytes.load(std::memory_order_relaxed);
+        result.num_allocations = counters[tag].num_allocations.load(std::memory_order_relaxed);
+        result.peak_bytes = counters[tag].peak_bytes.load(std::memory_order_relaxed);
+        result.frame_bytes = counters[tag].last_frame_bytes;
+        result.frame_allocations = counters[tag].last_frame_allocations;
+    }
+
+    return result;
+}
+
+const char *memtrack::get_tag_name(QF_MemoryTag tag)
+{
+    if(tag < MEMTAG_COUNT)
+        return tag_names[tag];
+    return "unknown";
+}
+
+std::size_t memtrack::frame_allocations(void)
+{
+    std::size_t result = 0;
+
+    for(const auto &counter : counters)
+        result += counter.last_frame_allocations;
+    return result;
+}
+
+#if ENABLE_MEMTRACK
+
+// Replacing the global allocation functions routes every
+// new/delete expression in the program through the tracker;
+// this lives in the same translation unit as memtrack::update_frame
+// so that linking against it is enough to pull the replacements in
+
+void *operator new(std::size_t size)
+{
+    if(auto pointer = tracked_allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__, current_tag))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size)
+{
+    if(auto pointer = tracked_allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__, current_tag))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment)
+{
+    if(auto pointer = tracked_allocate(size, static_cast<std::size_t>(alignment), current_tag))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment)
+{
+    if(auto pointer = tracked_allocate(size, static_cast<std::size_t>(alignment), current_tag))
+        return pointer;
+    throw std::bad_alloc();
+}
+
+void *operator new(std::size_t size, const std::nothrow_t &) noexcept
+{
+    return tracked_allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__, current_tag);
+}
+
+void *operator new[](std::size_t size, const std::nothrow_t &) noexcept
+{
+    return tracked_allocate(size, __STDCPP_DEFAULT_NEW_ALIGNMENT__, current_tag);
+}
+
+void *operator new(std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return tracked_allocate(size, static_cast<std::size_t>(alignment), current_tag);
+}
+
+void *operator new[](std::size_t size, std::align_val_t alignment, const std::nothrow_t &) noexcept
+{
+    return tracked_allocate(size, static_cast<std::size_t>(alignment), current_tag);
+}
+
+void operator delete(void *pointer) noexcept
+{
+    tracked_deallocate(pointer);
+}
+
+void operator delete[](void *pointer) noexcept
+{
+    tracked_deallocate(pointer);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept
+{
+    tracked_deallocate(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t) noexcept
+{
+    tracked_deallocate(pointer);
+}
+
+void operator delete(void *pointer, std::align_val_t) noexcept
+{
+    tracked_deallocate(pointer);
+}
+
+void operator delete[](void *pointer, std::align_val_t) noexcept
+{
+    tracked_deallocate(pointer);
+}
+
+void operator delete(void *pointer, std::size_t, std::align_val_t) noexcept
+{
+    tracked_deallocate(pointer);
+}
+
+void operator delete[](void *pointer, std::size_t, std::align_val_t) noexcept
+{
+    tracked_deallocate(pointer);
+}
+
+void operator delete(void *pointer, const std::nothrow_t &) noexcept
+{
+    tracked_deallocate(pointer);
+}
+
+void operator delete[](void *pointer, const std::nothrow_t &) noexcept
+{
+    tracked_deallocate(pointer);
+}
+
+#endif /* ENABLE_MEMTRACK */
@@ -0,0 +1,193 @@
+#ifndef CORE_MEMTRACK_HH
+#define CORE_MEMTRACK_HH 1
+#pragma once
+
+#include "core/feature.hh"
+
+/**
+ * Subsystem tags memory allocations are accounted under;
+ * untagged allocations go into MEMTAG_GENERAL
+ */
+enum QF_MemoryTag : unsigned int {
+    MEMTAG_GENERAL  = 0x0000,   ///< Anything not tagged otherwise
+    MEMTAG_CONFIG   = 0x0001,   ///< Config registry and files
+    MEMTAG_LOGGING  = 0x0002,   ///< Logging queue and callbacks
+    MEMTAG_PROFILER = 0x0003,   ///< Profiler buffers and captures
+    MEMTAG_REGISTRY = 0x0004,   ///< EnTT registry and dispatcher
+    MEMTAG_NETWORK  = 0x0005,   ///< Packet buffers
+    MEMTAG_IMGUI    = 0x0006,   ///< Dear ImGui
+    MEMTAG_PHYSFS   = 0x0007,   ///< PhysicsFS
+    MEMTAG_RENDER   = 0x0008,   ///< Renderer resources
+    MEMTAG_COUNT,
+};
+
+/**
+ * Allocation counters of a single tag
+ */
+struct MemoryStats final {
+    std::size_t num_bytes;          ///< Currently allocated bytes
+    std::size_t num_allocations;    ///< Currently live allocations
+    std::size_t peak_bytes;         ///< Highest num_bytes ever seen
+    std::size_t frame_bytes;        ///< Bytes allocated during the last frame
+    std::size_t frame_allocations;  ///< Allocations made during the last frame
+};
+
+/**
+ * Makes allocations done by the current thread within
+ * its scope count towards the given tag; scopes nest
+ */
+class MemoryTagScope final {
+public:
+    explicit MemoryTagScope(QF_MemoryTag tag);
+    MemoryTagScope(const MemoryTagScope &other) = delete;
+    MemoryTagScope &operator=(const MemoryTagScope &other) = delete;
+    ~MemoryTagScope(void);
+
+private:
+    QF_MemoryTag previous_tag;
+};
+
+/**
+ * A standard library allocator that accounts its
+ * memory under a fixed tag; meant for containers owned by
+ * a subsystem but touched from code running under other tags;
+ * not final since standard containers may derive from allocators
+ */
+template<typename T, QF_MemoryTag Tag>
+struct TaggedAllocator {
+    using value_type = T;
+
+    template<typename U>
+    struct rebind final {
+        using other = TaggedAllocator<U, Tag>;
+    };
+
+    TaggedAllocator(void) noexcept = default;
+
+    template<typename U>
+    TaggedAllocator(const TaggedAllocator<U, Tag> &other) noexcept;
+
+    T *allocate(std::size_t count);
+    void deallocate(T *pointer, std::size_t count) noexcept;
+};
+
+template<typename T, typename U, QF_MemoryTag Tag>
+constexpr static inline bool operator==(const TaggedAllocator<T, Tag> &a, const TaggedAllocator<U, Tag> &b);
+
+template<typename T, typename U, QF_MemoryTag Tag>
+constexpr static inline bool operator!=(const TaggedAllocator<T, Tag> &a, const TaggedAllocator<U, Tag> &b);
+
+namespace memtrack
+{
+/**
+ * Installs allocation hooks into third-party libraries
+ * that support custom allocators; must be called before
+ * any of them are initialized (i.e. before PHYSFS_init)
+ */
+void init(void);
+
+/**
+ * Logs memory that is still allocated; subsystems
+ * that live until the process exits (i.e. the config
+ * registry) will show up here as well, anything else
+ * is most likely leaked
+ */
+void report_leaks(void);
+
+/**
+ * Finishes a frame worth of allocation statistics
+ * @note Should be called once per frame from the main thread
+ */
+void update_frame(void);
+} // namespace memtrack
+
+namespace memtrack
+{
+/**
+ * Allocates memory accounted under a specific tag
+ * regardless of the current thread's tag
+ * @param size Amount of bytes
+ * @param alignment Alignment, must be a power of two
+ * @param tag Memory tag
+ * @returns Allocated memory or nullptr
+ */
+void *allocate(std::size_t size, std::size_t alignment, QF_MemoryTag tag);
+
+/**
+ * Frees memory obtained from memtrack::allocate
+ * @param pointer Allocated memory or nullptr
+ */
+void deallocate(void *pointer);
+} // namespace memtrack
+
+namespace memtrack
+{
+/**
+ * Get a tag's allocation counters
+ * @param tag Memory tag
+ * @returns Counters, all zero when ENABLE_MEMTRACK is off
+ */
+MemoryStats get_stats(QF_MemoryTag tag);
+
+/**
+ * Get a tag's human-readable name
+ * @param tag Memory tag
+ * @returns Tag name
+ */
+const char *get_tag_name(QF_MemoryTag tag);
+
+/**
+ * Figure out how many allocations were made during the last
+ * frame across all tags; in a steady state this should be zero
+ * @returns Amount of allocations
+ */
+std::size_t frame_allocations(void);
+} // namespace memtrack
+
+template<typename T, QF_MemoryTag Tag>
+template<typename U>
+inline TaggedAllocator<T, Tag>::TaggedAllocator(const TaggedAllocator<U, Tag> &) noexcept
+{
+
+}
+
+template<typename T, QF_MemoryTag Tag>
+inline T *TaggedAllocator<T, Tag>::allocate(std::size_t count)
+{
+    if(auto pointer = memtrack::allocate(count * sizeof(T), alignof(T), Tag))
+        return static_cast<T *>(pointer);
+    throw std::bad_alloc();
+}
+
+template<typename T, QF_MemoryTag Tag>
+inline void TaggedAllocator<T, Tag>::deallocate(T *pointer, std::size_t) noexcept
+{
+    memtrack::deallocate(pointer);
+}
+
+template<typename T, typename U, QF_MemoryTag Tag>
+constexpr static inline bool operator==(const TaggedAllocator<T, Tag> &, const TaggedAllocator<U, Tag> &)
+{
+    return true;
+}
+
+template<typename T, typename U, QF_MemoryTag Tag>
+constexpr static inline bool operator!=(const TaggedAllocator<T, Tag> &, const TaggedAllocator<U, Tag> &)
+{
+    return false;
+}
+
+#if ENABLE_MEMTRACK
+/**
+ * Accounts allocations made within the rest
+ * of the enclosing scope under the given tag
+ * @param tag Memory tag
+ */
+#define QF_memory_tag(tag) MemoryTagScope QF_MEMTRACK_CONCAT(memory_tag_, __LINE__)((tag))
+#define QF_MEMTRACK_CONCAT_IMPL(x, y) x##y
+#define QF_MEMTRACK_CONCAT(x, y) QF_MEMTRACK_CONCAT_IMPL(x, y)
+#else
+#define QF_memory_tag(tag) static_cast<void>(0)
+#endif /* ENABLE_MEMTRACK */
+
+#endif /* CORE_MEMTRACK_HH */
@@ -0,0 +1,485 @@
+#include "core/precompiled.hh"
+#include "core/profiler.hh"
+
+#include "core/cmdline.hh"
+#include "core/config.hh"
+#include "core/constexpr.hh"
+#include "core/epoch.hh"
+#include "core/logging.hh"
+#include "core/memtrack.hh"
+
+#if ENABLE_PROFILER
+
+// Per-thread ring buffer size; must be a power of two
+// and large enough to hold a frame's worth of zones
+constexpr static std::size_t PROFILER_BUFFER_SIZE = 16384;
+
+// Same as above but for counter samples
+constexpr static std::size_t PROFILER_COUNTER_BUFFER_SIZE = 1024;
+
+// Each thread only ever writes into its own buffer and
+// the main thread drains all of them in profiler::end_frame,
+// so publishing an event is a single release store; a thread
+// that fills its buffer up drops new zones until it's drained;
+// counter samples go through a separate ring the same way
+struct ProfilerBuffer final {
+    std::atomic<std::uint64_t> write_index;
+    std::atomic<std::uint64_t> read_index;
+    std::atomic<std::uint64_t> counter_write_index;
+    std::atomic<std::uint64_t> counter_read_index;
+    std::atomic<std::size_t> num_dropped;
+    std::uint32_t thread;
+    std::uint32_t depth;
+    std::string name;
+    ProfilerEvent events[PROFILER_BUFFER_SIZE];
+    ProfilerCounter counters[PROFILER_COUNTER_BUFFER_SIZE];
+};
+
+static std::atomic<bool> profiler_enabled = true;
+
+static std::mutex buffers_mutex;
+static std::vector<std::unique_ptr<ProfilerBuffer>> buffers;
+thread_local static ProfilerBuffer *local_buffer = nullptr;
+
+static ProfilerFrame current_frame = {};
+static ProfilerFrame previous_frame = {};
+static std::size_t frame_dropped = 0;
+static std::size_t previous_dropped = 0;
+
+// Setting this from a config file or the console
+// starts a capture of that many frames
+static ConfigHandle<unsigned int> capture_frames;
+static std::uint32_t capture_generation;
+
+static PHYSFS_File *capture_file = nullptr;
+static std::string capture_filename;
+static std::size_t capture_remaining = 0;
+static std::uint64_t capture_start_ns = 0;
+static bool capture_first_event = true;
+static std::string capture_buffer;
+
+static ProfilerBuffer *get_local_buffer(void)
+{
+    QF_memory_tag(MEMTAG_PROFILER);
+
+    if(local_buffer == nullptr) {
+        std::lock_guard<std::mutex> lock(buffers_mutex);
+
+        // Buffers outlive their threads; threads
+        // come and go much less often than frames
+        local_buffer = buffers.emplace_back(std::make_unique<ProfilerBuffer>()).get();
+        local_buffer->write_index.store(UINT64_C(0), std::memory_order_relaxed);
+        local_buffer->read_index.store(UINT64_C(0), std::memory_order_relaxed);
+        local_buffer->counter_write_index.store(UINT64_C(0), std::memory_order_relaxed);
+        local_buffer->counter_read_index.store(UINT64_C(0), std::memory_order_relaxed);
+        local_buffer->num_dropped.store(0, std::memory_order_relaxed);
+        local_buffer->thread = static_cast<std::uint32_t>(buffers.size() - 1);
+        local_buffer->depth = UINT32_C(0);
+        local_buffer->name = "thread " + std::to_string(local_buffer->thread);
+    }
+
+    return local_buffer;
+}
+
+ProfilerZone::ProfilerZone(const char *name)
+{
+    if(profiler_enabled.load(std::memory_order_relaxed)) {
+        get_local_buffer()->depth += 1;
+        this->name = name;
+        this->start_ns = epoch::monotonic_ns();
+    }
+    else {
+        this->name = nullptr;
+        this->start_ns = UINT64_C(0);
+    }
+}
+
+ProfilerZone::~ProfilerZone(void)
+{
+    if(name) {
+        const std::uint64_t end_ns = epoch::monotonic_ns();
+        ProfilerBuffer *buffer = local_buffer;
+
+        buffer->depth -= 1;
+
+        const std::uint64_t index = buffer->write_index.load(std::memory_order_relaxed);
+
+        if(index - buffer->read_index.load(std::memory_order_acquire) >= PROFILER_BUFFER_SIZE) {
+            buffer->num_dropped.fetch_add(1, std::memory_order_relaxed);
+            return;
+        }
+
+        ProfilerEvent &event = buffer->events[index & (PROFILER_BUFFER_SIZE - 1)];
+        event.name = name;
+        event.start_ns = start_ns;
+        event.end_ns = end_ns;
+        event.thread = buffer->thread;
+        event.depth = buffer->depth;
+        buffer->write_index.store(index + 1, std::memory_order_release);
+    }
+}
+
+static void append_json_string(std::string &buffer, const char *string)
+{
+    buffer.push_back('"');
+
+    for(const char *c = string; *c; ++c) {
+        if((*c == '"') || (*c == '\\')) {
+            buffer.push_back('\\');
+            buffer.push_back(*c);
+        }
+        else if(static_cast<unsigned char>(*c) >= 0x20) {
+            buffer.push_back(*c);
+        }
+    }
+
+    buffer.push_back('"');
+}
+
+static void append_trace_event(std::string &buffer, const char *format, ...)
+{
+    char string[256];
+
+    std::va_list va;
+    va_start(va, format);
+    auto count = stbsp_vsnprintf(string, sizeof(string), format, va);
+    va_end(va);
+
+    buffer.append(string, cxpr::clamp<std::size_t>(count, 0, sizeof(string) - 1));
+}
+
+static void begin_trace_event(std::string &buffer)
+{
+    if(!capture_first_event)
+        buffer.append(",\n");
+    capture_first_event = false;
+}
+
+// Trace event timestamps are in microseconds
+static double to_trace_time(std::uint64_t time_ns)
+{
+    return static_cast<double>(time_ns - cxpr::min(time_ns, capture_start_ns)) / 1000.0;
+}
+
+static void write_captured_frame(const ProfilerFrame &frame)
+{
+    capture_buffer.clear();
+
+    begin_trace_event(capture_buffer);
+    append_trace_event(capture_buffer, "{\"name\":\"frame %" PRIu64 "\",\"ph\":\"i\",\"s\":\"g\",\"pid\":0,\"tid\":0,\"ts\":%.3f}",
+        frame.number, to_trace_time(frame.end_ns));
+
+    for(const auto &event : frame.events) {
+        begin_trace_event(capture_buffer);
+        capture_buffer.append("{\"name\":");
+        append_json_string(capture_buffer, event.name);
+        append_trace_event(capture_buffer, ",\"ph\":\"X\",\"pid\":0,\"tid\":%u,\"ts\":%.3f,\"dur\":%.3f}",
+            event.thread, to_trace_time(event.start_ns), static_cast<double>(event.end_ns - event.start_ns) / 1000.0);
+    }
+
+    for(const auto &counter : frame.counters) {
+        begin_trace_event(capture_buffer);
+        capture_buffer.append("{\"name\":");
+        append_json_string(capture_buffer, counter.name);
+        append_trace_event(capture_buffer, ",\"ph\":\"C\",\"pid\":0,\"ts\":%.3f,\"args\":{\"value\":%.6g}}",
+            to_trace_time(counter.time_ns), counter.value);
+    }
+
+    PHYSFS_writeBytes(capture_file, capture_buffer.data(), capture_buffer.size());
+}
+
+// Expects buffers_mutex to be locked
+static void finish_capture(void)
+{
+    if(capture_file == nullptr)
+        return;
+
+    capture_buffer.clear();
+
+    // Thread names go last since threads
+    // may have been named during the capture
+    for(const auto &buffer : buffers) {
+        begin_trace_event(capture_buffer);
+        append_trace_event(capture_buffer, "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":%u,\"args\":{\"name\":", buffer->thread);
+        append_json_string(capture_buffer, buffer->name.c_str());
+        capture_buffer.append("}}");
+    }
+
+    capture_buffer.append("\n]}\n");
+
+    PHYSFS_writeBytes(capture_file, capture_buffer.data(), capture_buffer.size());
+    PHYSFS_close(capture_file);
+
+    QF_inform("profiler: wrote %s", capture_filename.c_str());
+
+    capture_file = nullptr;
+    capture_remaining = 0;
+    capture_buffer = std::string();
+}
+
+void profiler::init(void)
+{
+    capture_frames = config::add<unsigned int>("profiler.capture_frames", 0U, FCONFIG_NO_SAVE);
+    capture_generation = config::generation(capture_frames);
+
+    if(cmdline::contains("profile-capture")) {
+        auto num_frames = std::strtoul(cmdline::get("profile-capture", "300"), nullptr, 10);
+        profiler::start_capture(num_frames ? num_frames : 300);
+    }
+}
+
+void profiler::deinit(void)
+{
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+    finish_capture();
+}
+
+void profiler::set_enabled(bool enable)
+{
+    profiler_enabled.store(enable, std::memory_order_relaxed);
+}
+
+bool profiler::is_enabled(void)
+{
+    return profiler_enabled.load(std::memory_order_relaxed);
+}
+
+void profiler::set_thread_name(const char *name)
+{
+    auto buffer = get_local_buffer();
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+    buffer->name = name;
+}
+
+std::size_t profiler::num_threads(void)
+{
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+    return buffers.size();
+}
+
+std::string profiler::get_thread_name(std::uint32_t thread)
+{
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+
+    if(thread < buffers.size())
+        return buffers[thread]->name;
+    return std::string();
+}
+
+void profiler::end_frame(void)
+{
+    QF_memory_tag(MEMTAG_PROFILER);
+
+    if(capture_frames.cell && (config::generation(capture_frames) != capture_generation)) {
+        capture_generation = config::generation(capture_frames);
+
+        if(auto num_frames = config::get(capture_frames)) {
+            profiler::start_capture(num_frames);
+        }
+    }
+
+    const std::uint64_t now = epoch::monotonic_ns();
+
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+
+    for(auto &buffer : buffers) {
+        const std::uint64_t write_index = buffer->write_index.load(std::memory_order_acquire);
+        const std::uint64_t read_index = buffer->read_index.load(std::memory_order_relaxed);
+
+        for(std::uint64_t i = read_index; i < write_index; ++i) {
+            current_frame.events.push_back(buffer->events[i & (PROFILER_BUFFER_SIZE - 1)]);
+        }
+
+        buffer->read_index.store(write_index, std::memory_order_release);
+
+        const std::uint64_t counter_write_index = buffer->counter_write_index.load(std::memory_order_acquire);
+        const std::uint64_t counter_read_index = buffer->counter_read_index.load(std::memory_order_relaxed);
+
+        for(std::uint64_t i = counter_read_index; i < counter_write_index; ++i) {
+            current_frame.counters.push_back(buffer->counters[i & (PROFILER_COUNTER_BUFFER_SIZE - 1)]);
+        }
+
+        buffer->counter_read_index.store(counter_write_index, std::memory_order_release);
+
+        frame_dropped += buffer->num_dropped.exchange(0, std::memory_order_relaxed);
+    }
+
+    if(current_frame.start_ns == 0) {
+        // The very first frame started whenever
+        // the earliest zone we know of started
+        current_frame.start_ns = now;
+
+        for(const auto &event : current_frame.events) {
+            current_frame.start_ns = cxpr::min(current_frame.start_ns, event.start_ns);
+        }
+    }
+
+    current_frame.end_ns = now;
+
+    std::swap(previous_frame, current_frame);
+    previous_dropped = frame_dropped;
+
+    current_frame.number = previous_frame.number + 1;
+    current_frame.start_ns = now;
+    current_frame.end_ns = now;
+    current_frame.events.clear();
+    current_frame.counters.clear();
+    frame_dropped = 0;
+
+    if(capture_file) {
+        write_captured_frame(previous_frame);
+
+        if(--capture_remaining == 0) {
+            finish_capture();
+        }
+    }
+}
+
+const ProfilerFrame &profiler::last_frame(void)
+{
+    return previous_frame;
+}
+
+std::size_t profiler::num_dropped(void)
+{
+    return previous_dropped;
+}
+
+void profiler::set_counter(const char *name, double value)
+{
+    if(!profiler_enabled.load(std::memory_order_relaxed))
+        return;
+
+    ProfilerBuffer *buffer = get_local_buffer();
+
+    const std::uint64_t index = buffer->counter_write_index.load(std::memory_order_relaxed);
+
+    if(index - buffer->counter_read_index.load(std::memory_order_acquire) >= PROFILER_COUNTER_BUFFER_SIZE) {
+        buffer->num_dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    ProfilerCounter &counter = buffer->counters[index & (PROFILER_COUNTER_BUFFER_SIZE - 1)];
+    counter.name = name;
+    counter.time_ns = epoch::monotonic_ns();
+    counter.value = value;
+    buffer->counter_write_index.store(index + 1, std::memory_order_release);
+}
+
+void profiler::start_capture(std::size_t num_frames)
+{
+    QF_memory_tag(MEMTAG_PROFILER);
+
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+
+    if(capture_file || (num_frames == 0))
+        return;
+
+    PHYSFS_mkdir("profiles");
+
+    // Captures started within the same second
+    // get told apart by a sequence number
+    const std::uint64_t seconds = epoch::seconds();
+    unsigned int sequence = 0U;
+    char filename[128];
+
+    do {
+        stbsp_snprintf(filename, sizeof(filename), "profiles/capture-%" PRIu64 "-%u.json", seconds, sequence++);
+    } while(PHYSFS_exists(filename));
+
+    capture_file = PHYSFS_openWrite(filename);
+
+    if(capture_file == nullptr) {
+        QF_warning("profiler: %s: %s", filename, PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
+        return;
+    }
+
+    capture_filename = filename;
+    capture_remaining = num_frames;
+    capture_start_ns = epoch::monotonic_ns();
+    capture_first_event = true;
+
+    const char *header = "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+    PHYSFS_writeBytes(capture_file, header, std::strlen(header));
+
+    // Recording is pointless otherwise
+    profiler_enabled.store(true, std::memory_order_relaxed);
+
+    QF_inform("profiler: capturing %zu frames into %s", num_frames, filename);
+}
+
+bool profiler::is_capturing(void)
+{
+    std::lock_guard<std::mutex> lock(buffers_mutex);
+    return capture_file != nullptr;
+}
+
+#else
+
+// With ENABLE_PROFILER disabled nothing records zones
+// or counters, so the rest of the API is kept as no-ops
+// that callers don't need to wrap in preprocessor checks
+
+void profiler::init(void)
+{
+    if(cmdline::contains("profile-capture")) {
+        QF_warning("profiler: -profile-capture: the profiler is disabled at build time");
+    }
+}
+
+void profiler::deinit(void)
+{
+}
+
+void profiler::set_enabled(bool)
+{
+}
+
+bool profiler::is_enabled(void)
+{
+    return false;
+}
+
+void profiler::set_thread_name(const char *)
+{
+}
+
+std::size_t profiler::num_threads(void)
+{
+    return 0;
+}
+
+std::string profiler::get_thread_name(std::uint32_t)
+{
+    return std::string();
+}
+
+void profiler::end_frame(void)
+{
+}
+
+const ProfilerFrame &profiler::last_frame(void)
+{
+    static const ProfilerFrame empty_frame = {};
+    return empty_frame;
+}
+
+std::size_t profiler::num_dropped(void)
+{
+    return 0;
+}
+
+void profiler::set_counter(const char *, double)
+{
+}
+
+void profiler::start_capture(std::size_t)
+{
+}
+
+bool profiler::is_capturing(void)
+{
+    return false;
+}
+
+#endif /* ENABLE_PROFILER */
@@ -0,0 +1,193 @@
+#ifndef CORE_PROFILER_HH
+#define CORE_PROFILER_HH 1
+#pragma once
+
+#include "core/feature.hh"
+
+/**
+ * A single finished zone
+ */
+struct ProfilerEvent final {
+    const char *name;           ///< Zone name, must be a string literal
+    std::uint64_t start_ns;     ///< Monotonic time the zone was entered at
+    std::uint64_t end_ns;       ///< Monotonic time the zone was left at
+    std::uint32_t thread;       ///< Index of the thread that recorded the zone
+    std::uint32_t depth;        ///< Nesting level within the thread
+};
+
+/**
+ * A single sample of a named value
+ */
+struct ProfilerCounter final {
+    const char *name;           ///< Counter name, must be a string literal
+    std::uint64_t time_ns;      ///< Monotonic time the sample was taken at
+    double value;
+};
+
+/**
+ * Zones collected over a single frame
+ */
+struct ProfilerFrame final {
+    std::uint64_t number;
+    std::uint64_t start_ns;
+    std::uint64_t end_ns;
+    std::vector<ProfilerEvent> events;
+    std::vector<ProfilerCounter> counters;
+};
+
+#if ENABLE_PROFILER
+/**
+ * Records the time spent within its scope as a zone;
+ * use QF_profile_zone instead so that profiling can be
+ * compiled out completely by disabling ENABLE_PROFILER
+ */
+class ProfilerZone final {
+public:
+    explicit ProfilerZone(const char *name);
+    ProfilerZone(const ProfilerZone &other) = delete;
+    ProfilerZone &operator=(const ProfilerZone &other) = delete;
+    ~ProfilerZone(void);
+
+private:
+    const char *name;
+    std::uint64_t start_ns;
+};
+#endif /* ENABLE_PROFILER */
+
+namespace profiler
+{
+/**
+ * Registers profiler config variables and starts
+ * a capture if requested with the `-profile-capture`
+ * command line option; capture length in frames can
+ * be passed as the option's argument
+ * @note With ENABLE_PROFILER disabled the whole
+ * profiler API is kept but does nothing
+ */
+void init(void);
+
+/**
+ * Finishes an ongoing capture
+ */
+void deinit(void);
+} // namespace profiler
+
+namespace profiler
+{
+/**
+ * Enables or disables zone recording at runtime;
+ * disabled zones cost a single relaxed atomic load
+ * @param enable Whether to record zones
+ */
+void set_enabled(bool enable);
+
+/**
+ * Checks whether zone recording is enabled
+ * @returns true if zones are being recorded
+ */
+bool is_enabled(void);
+} // namespace profiler
+
+namespace profiler
+{
+/**
+ * Names the calling thread in profiler output
+ * @param name Thread name
+ */
+void set_thread_name(const char *name);
+
+/**
+ * Figure out how many threads have recorded zones
+ * @returns Amount of threads
+ */
+std::size_t num_threads(void);
+
+/**
+ * Figure out a thread's name
+ * @param thread Thread index from ProfilerEvent::thread
+ * @returns Thread name
+ */
+std::string get_thread_name(std::uint32_t thread);
+} // namespace profiler
+
+namespace profiler
+{
+/**
+ * Collects zones recorded by all threads since the
+ * previous call and makes them the last complete frame
+ * @note Should be called once per frame from the main thread
+ */
+void end_frame(void);
+
+/**
+ * Get the last complete frame
+ * @returns Frame data, valid until the next profiler::end_frame
+ * @note Should only be called from the main thread
+ */
+const ProfilerFrame &last_frame(void);
+
+/**
+ * Figure out how many zones and counter samples were lost because
+ * a thread recorded more than its buffers fit within a single frame
+ * @returns Amount of records dropped during the last frame
+ */
+std::size_t num_dropped(void);
+} // namespace profiler
+
+namespace profiler
+{
+/**
+ * Records a sample of a named value; like zones, samples
+ * are not recorded while recording is disabled
+ * @param name Counter name, must be a string literal
+ * @param value Counter value
+ */
+void set_counter(const char *name, double value);
+} // namespace profiler
+
+namespace profiler
+{
+/**
+ * Starts writing frames into a Chrome trace event JSON
+ * file (loadable with chrome://tracing or Perfetto UI) under
+ * `profiles/` in the write directory; does nothing if there
+ * is a capture already running
+ * @param num_frames Amount of frames to capture
+ */
+void start_capture(std::size_t num_frames);
+
+/**
+ * Checks whether a capture is running
+ * @returns true if frames are being written out
+ */
+bool is_capturing(void);
+} // namespace profiler
+
+#define QF_PROFILE_CONCAT_IMPL(x, y) x##y
+#define QF_PROFILE_CONCAT(x, y) QF_PROFILE_CONCAT_IMPL(x, y)
+
+#if ENABLE_PROFILER
+/**
+ * Records the rest of the enclosing scope as a named zone
+ * @param name Zone name, must be a string literal
+ */
+#define QF_profile_zone(name) ProfilerZone QF_PROFILE_CONCAT(profiler_zone_, __LINE__)((name))
+
+/**
+ * Records the rest of the enclosing function as a zone
+ */
+#define QF_profile_function() ProfilerZone QF_PROFILE_CONCAT(profiler_zone_, __LINE__)(__func__)
+
+/**
+ * Records a sample of a named value
+ * @param name Counter name, must be a string literal
+ * @param value Counter value
+ */
+#define QF_profile_counter(name, value) profiler::set_counter((name), static_cast<double>(value))
+#else
+#define QF_profile_zone(name) static_cast<void>(0)
+#define QF_profile_function() static_cast<void>(0)
+#define QF_profile_counter(name, value) static_cast<void>(0)
+#endif /* ENABLE_PROFILER */
+
+#endif /* CORE_PROFILER_HH */
@@ -0,0 +1,41 @@
+#include "core/precompiled.hh"
+#include "core/queue.hh"
+
+std::uint32_t ThreadNotifier::prepare_wait(void)
+{
+    num_waiters.fetch_add(1U, std::memory_order_seq_cst);
+    return epoch.load(std::memory_order_seq_cst);
+}
+
+void ThreadNotifier::cancel_wait(void)
+{
+    num_waiters.fetch_sub(1U, std::memory_order_relaxed);
+}
+
+void ThreadNotifier::commit_wait(std::uint32_t key)
+{
+    // Returns right away if anything was
+    // notified since ThreadNotifier::prepare_wait
+    epoch.wait(key, std::memory_order_seq_cst);
+    num_waiters.fetch_sub(1U, std::memory_order_relaxed);
+}
+
+void ThreadNotifier::notify_one(void)
+{
+    // A read-modify-write instead of a plain load; either
+    // it sees a consumer's increment in prepare_wait or that
+    // increment reads from it, which makes the producer's push
+    // visible to the consumer's last check of the queue
+    if(num_waiters.fetch_add(0U, std::memory_order_seq_cst)) {
+        epoch.fetch_add(1U, std::memory_order_seq_cst);
+        epoch.notify_one();
+    }
+}
+
+void ThreadNotifier::notify_all(void)
+{
+    if(num_waiters.fetch_add(0U, std::memory_order_seq_cst)) {
+        epoch.fetch_add(1U, std::memory_order_seq_cst);
+        epoch.notify_all();
+    }
+}
@@ -0,0 +1,280 @@
+#ifndef CORE_QUEUE_HH
+#define CORE_QUEUE_HH 1
+#pragma once
+
+#include "core/assert.hh"
+
+// Indices touched by different threads are kept
+// this far apart so that they don't false-share
+constexpr static std::size_t CACHE_LINE_SIZE = 64;
+
+/**
+ * Bounded single-producer single-consumer ring queue
+ * @note T must be default constructible and move assignable
+ */
+template<typename T>
+class SPSCQueue final {
+public:
+    explicit SPSCQueue(std::size_t capacity);
+    SPSCQueue(const SPSCQueue &other) = delete;
+    SPSCQueue &operator=(const SPSCQueue &other) = delete;
+
+    /**
+     * Adds an element; producer thread only
+     * @returns false if the queue is full
+     */
+    bool try_push(T value);
+
+    /**
+     * Takes the oldest element; consumer thread only
+     * @returns false if the queue is empty
+     */
+    bool try_pop(T &value);
+
+    /**
+     * @returns Amount of elements; only a hint
+     * while the other thread is active
+     */
+    std::size_t size_approx(void) const;
+
+private:
+    std::size_t mask;
+    std::unique_ptr<T[]> slots;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> head;
+    std::size_t cached_tail;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> tail;
+    std::size_t cached_head;
+};
+
+/**
+ * Bounded multi-producer multi-consumer ring queue
+ * @note T must be default constructible and move assignable
+ * @see Dmitry Vyukov's bounded MPMC queue
+ */
+template<typename T>
+class MPMCQueue final {
+public:
+    explicit MPMCQueue(std::size_t capacity);
+    MPMCQueue(const MPMCQueue &other) = delete;
+    MPMCQueue &operator=(const MPMCQueue &other) = delete;
+
+    /**
+     * Adds an element; thread-safe
+     * @returns false if the queue is full
+     */
+    bool try_push(T value);
+
+    /**
+     * Takes the oldest element; thread-safe
+     * @returns false if the queue is empty
+     */
+    bool try_pop(T &value);
+
+    /**
+     * @returns Amount of elements; only a hint
+     * while other threads are active
+     */
+    std::size_t size_approx(void) const;
+
+private:
+    // Sequence tells whose turn it is to use the cell;
+    // equal to the position when it's free to be written
+    // and to the position + 1 when it holds an element
+    struct Cell final {
+        std::atomic<std::size_t> sequence;
+        T value;
+    };
+
+    std::size_t mask;
+    std::unique_ptr<Cell[]> cells;
+
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> enqueue_pos;
+    alignas(CACHE_LINE_SIZE) std::atomic<std::size_t> dequeue_pos;
+};
+
+/**
+ * Lets consumers sleep while a queue is empty
+ * without producers paying for a syscall on every
+ * push; consumers announce themselves first and
+ * check the queue once more before going to sleep:
+ *
+ *     while(!queue.try_pop(value)) {
+ *         auto key = notifier.prepare_wait();
+ *         if(queue.try_pop(value)) {
+ *             notifier.cancel_wait();
+ *             break;
+ *         }
+ *         notifier.commit_wait(key);
+ *     }
+ *
+ * and producers call notify_one or notify_all after pushing
+ */
+class ThreadNotifier final {
+public:
+    ThreadNotifier(void) = default;
+    ThreadNotifier(const ThreadNotifier &other) = delete;
+    ThreadNotifier &operator=(const ThreadNotifier &other) = delete;
+
+    std::uint32_t prepare_wait(void);
+    void cancel_wait(void);
+    void commit_wait(std::uint32_t key);
+
+    void notify_one(void);
+    void notify_all(void);
+
+private:
+    std::atomic<std::uint32_t> epoch = 0U;
+    std::atomic<std::uint32_t> num_waiters = 0U;
+};
+
+// Rounds the requested capacity up to a power of two
+static inline std::size_t queue_capacity(std::size_t capacity)
+{
+    // Anything larger has no power of two to round up to
+    QF_assert(capacity <= (std::numeric_limits<std::size_t>::max() / 2U) + 1U);
+
+    std::size_t result = 2;
+    while(result < capacity)
+        result <<= 1;
+    return result;
+}
+
+template<typename T>
+inline SPSCQueue<T>::SPSCQueue(std::size_t capacity)
+{
+    const std::size_t size = queue_capacity(capacity);
+
+    mask = size - 1;
+    slots = std::make_unique<T[]>(size);
+
+    head.store(0, std::memory_order_relaxed);
+    tail.store(0, std::memory_order_relaxed);
+    cached_tail = 0;
+    cached_head = 0;
+}
+
+template<typename T>
+inline bool SPSCQueue<T>::try_push(T value)
+{
+    const std::size_t position = tail.load(std::memory_order_relaxed);
+
+    // Only look at the consumer's index when the
+    // cached copy says the queue might be full
+    if(position - cached_head > mask) {
+        cached_head = head.load(std::memory_order_acquire);
+
+        if(position - cached_head > mask) {
+            return false;
+        }
+    }
+
+    slots[position & mask] = std::move(value);
+    tail.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+template<typename T>
+inline bool SPSCQueue<T>::try_pop(T &value)
+{
+    const std::size_t position = head.load(std::memory_order_relaxed);
+
+    if(position == cached_tail) {
+        cached_tail = tail.load(std::memory_order_acquire);
+
+        if(position == cached_tail) {
+            return false;
+        }
+    }
+
+    value = std::move(slots[position & mask]);
+    head.store(position + 1, std::memory_order_release);
+    return true;
+}
+
+template<typename T>
+inline std::size_t SPSCQueue<T>::size_approx(void) const
+{
+    const std::size_t position = head.load(std::memory_order_acquire);
+    return tail.load(std::memory_order_acquire) - position;
+}
+
+template<typename T>
+inline MPMCQueue<T>::MPMCQueue(std::size_t capacity)
+{
+    const std::size_t size = queue_capacity(capacity);
+
+    mask = size - 1;
+    cells = std::make_unique<Cell[]>(size);
+
+    for(std::size_t i = 0; i < size; ++i)
+        cells[i].sequence.store(i, std::memory_order_relaxed);
+
+    enqueue_pos.store(0, std::memory_order_relaxed);
+    dequeue_pos.store(0, std::memory_order_relaxed);
+}
+
+template<typename T>
+inline bool MPMCQueue<T>::try_push(T value)
+{
+    std::size_t position = enqueue_pos.load(std::memory_order_relaxed);
+
+    while(true) {
+        auto &cell = cells[position & mask];
+        const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        const auto difference = static_cast<std::ptrdiff_t>(sequence - position);
+
+        if(difference == 0) {
+            if(enqueue_pos.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                cell.value = std::move(value);
+                cell.sequence.store(position + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if(difference < 0) {
+            // The cell still holds an element from a lap ago
+            return false;
+        }
+        else {
+            position = enqueue_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+template<typename T>
+inline bool MPMCQueue<T>::try_pop(T &value)
+{
+    std::size_t position = dequeue_pos.load(std::memory_order_relaxed);
+
+    while(true) {
+        auto &cell = cells[position & mask];
+        const std::size_t sequence = cell.sequence.load(std::memory_order_acquire);
+        const auto difference = static_cast<std::ptrdiff_t>(sequence - (position + 1));
+
+        if(difference == 0) {
+            if(dequeue_pos.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) {
+                value = std::move(cell.value);
+                cell.sequence.store(position + mask + 1, std::memory_order_release);
+                return true;
+            }
+        }
+        else if(difference < 0) {
+            // Nothing has been written here yet
+            return false;
+        }
+        else {
+            position = dequeue_pos.load(std::memory_order_relaxed);
+        }
+    }
+}
+
+template<typename T>
+inline std::size_t MPMCQueue<T>::size_approx(void) const
+{
+    const std::size_t position = dequeue_pos.load(std::memory_order_acquire);
+    const std::size_t end = enqueue_pos.load(std::memory_order_acquire);
+    return (end > position) ? (end - position) : 0;
+}
+
+#endif /* CORE_QUEUE_HH */
@@ -1,8 +1,89 @@
 #include "core/precompiled.hh"
 #include "core/rwbuffer.hh"
 
+#include "core/byteorder.hh"
 #include "core/constexpr.hh"
 #include "core/floathacks.hh"
+#include "core/varint.hh"
+
+// Grows the buffer by the given amount of bytes
+// and returns a pointer to the newly appended region
+static inline std::byte *append(RWBuffer &buffer, std::size_t size)
+{
+    const std::size_t position = buffer.vector.size();
+    buffer.vector.resize(position + size);
+    return buffer.vector.data() + position;
+}
+
+template<typename T>
+static inline T read_big(RWBuffer &buffer)
+{
+    if((buffer.read_position + sizeof(T)) <= buffer.vector.size()) {
+        auto result = byteorder::load_big<T>(buffer.vector.data() + buffer.read_position);
+        buffer.read_position += sizeof(T);
+        return result;
+    }
+
+    buffer.read_position += sizeof(T);
+    return T(0);
+}
+
+// Arrays are processed as raw memory with the byte order
+// fixed up in-place; U is an unsigned integer type matching T
+template<typename T, typename U = T>
+static inline void read_big_array(RWBuffer &buffer, T *values, std::size_t count)
+{
+    static_assert(sizeof(T) == sizeof(U));
+    RWBuffer::read_bytes(buffer, values, count * sizeof(T));
+
+    if constexpr(!QF_BIG_ENDIAN) {
+        auto data = reinterpret_cast<std::byte *>(values);
+        for(std::size_t i = 0; i < count; ++i) {
+            auto value = byteorder::load_big<U>(data + i * sizeof(T));
+            std::memcpy(data + i * sizeof(T), &value, sizeof(T));
+        }
+    }
+}
+
+template<typename T, typename U = T>
+static inline void write_big_array(RWBuffer &buffer, const T *values, std::size_t count)
+{
+    static_assert(sizeof(T) == sizeof(U));
+
+    if constexpr(QF_BIG_ENDIAN) {
+        RWBuffer::write_bytes(buffer, values, count * sizeof(T));
+    }
+    else {
+        auto data = append(buffer, count * sizeof(T));
+        auto source = reinterpret_cast<const std::byte *>(values);
+        for(std::size_t i = 0; i < count; ++i) {
+            U value;
+            std::memcpy(&value, source + i * sizeof(T), sizeof(T));
+            byteorder::store_big<U>(data + i * sizeof(T), value);
+        }
+    }
+}
+
+// Strings may be truncated, in which case only the part
+// that is actually present in the data is returned
+static std::string_view read_string_data(RWBuffer &buffer, std::size_t size)
+{
+    std::size_t start = buffer.read_position;
+
+    // Lengths come straight off the wire; one past
+    // the end of the data doesn't fit a wrapping addition
+    // and still marks the reader as having run out of data
+    if((start > buffer.vector.size()) || (size > buffer.vector.size() - start)) {
+        buffer.read_position = buffer.vector.size() + 1;
+        return std::string_view();
+    }
+
+    buffer.read_position += size;
+
+    if(size == 0)
+        return std::string_view();
+    return std::string_view(reinterpret_cast<const char *>(buffer.vector.data() + start), size);
+}
 
 float RWBuffer::read_FP32(RWBuffer &buffer)
 {
@@ -31,78 +112,106 @@ std::int64_t RWBuffer::read_I64(RWBuffer &buffer)
 
 std::uint8_t RWBuffer::read_UI8(RWBuffer &buffer)
 {
-    if((buffer.read_position + 1U) <= buffer.vector.size()) {
-        auto result = static_cast<std::uint8_t>(buffer.vector[buffer.read_position]);
-        buffer.read_position += 1U;
-        return result;
-    }
-
-    buffer.read_position += 1U;
-    return UINT8_C(0);
+    return read_big<std::uint8_t>(buffer);
 }
 
 std::uint16_t RWBuffer::read_UI16(RWBuffer &buffer)
 {
-    if((buffer.read_position + 2U) <= buffer.vector.size()) {
-        std::uint16_t result = UINT16_C(0x0000);
-        result |= static_cast<std::uint16_t>(buffer.vector[buffer.read_position + 0U]) << 8U;
-        result |= static_cast<std::uint16_t>(buffer.vector[buffer.read_position + 1U]) << 0U;
-        buffer.read_position += 2U;
-        return result;
-    }
-
-    buffer.read_position += 2U;
-    return UINT16_C(0);
+    return read_big<std::uint16_t>(buffer);
 }
 
 std::uint32_t RWBuffer::read_UI32(RWBuffer &buffer)
 {
-    if((buffer.read_position + 4U) <= buffer.vector.size()) {
-        std::uint32_t result = UINT32_C(0x00000000);
-        result |= static_cast<std::uint32_t>(buffer.vector[buffer.read_position + 0U]) << 24U;
-        result |= static_cast<std::uint32_t>(buffer.vector[buffer.read_position + 1U]) << 16U;
-        result |= static_cast<std::uint32_t>(buffer.vector[buffer.read_position + 2U]) << 8U;
-        result |= static_cast<std::uint32_t>(buffer.vector[buffer.read_position + 3U]) << 0U;
-        buffer.read_position += 4U;
-        return result;
-    }
-
-    buffer.read_position += 4U;
-    return UINT32_C(0);
+    return read_big<std::uint32_t>(buffer);
 }
 
 std::uint64_t RWBuffer::read_UI64(RWBuffer &buffer)
 {
-    if((buffer.read_position + 8U) <= buffer.vector.size()) {
-        std::uint64_t result = UINT64_C(0x0000000000000000);
-        result |= static_cast<std::uint64_t>(buffer.vector[buffer.read_position + 0U]) << 56U;
-        result |= static_cast<std::uint64_t>(buffer.vector[buffer.read_position + 1U]) << 48U;
-        result |= static_cast<std::uint64_t>(buffer.vector[buffer.read_position + 2U]) << 40U;
-        result |= static_cast<std::uint64_t>(buffer.vector[buffer.read_position + 3U]) << 32U;
-        result |= static_cast<std::uint64_t>(buffer.vector[buffer.read_position + 4U]) << 24U;
-        result |= static_cast<std::uint64_t>(buffer.vector[buffer.read_position + 5U]) << 16U;
-        result |= static_cast<std::uint64_t>(buffer.vector[buffer.read_position + 6U]) << 8U;
-        result |= static_cast<std::uint64_t>(buffer.vector[buffer.read_position + 7U]) << 0U;
-        buffer.read_position += 8U;
-        return result;
+    return read_big<std::uint64_t>(buffer);
+}
+
+std::string RWBuffer::read_string(RWBuffer &buffer)
+{
+    return std::string(RWBuffer::read_string_view(buffer));
+}
+
+std::string_view RWBuffer::read_string_view(RWBuffer &buffer)
+{
+    return read_string_data(buffer, RWBuffer::read_UI16(buffer));
+}
+
+std::uint64_t RWBuffer::read_VUI64(RWBuffer &buffer)
+{
+    std::uint64_t result = UINT64_C(0);
+
+    if(buffer.read_position < buffer.vector.size()) {
+        auto count = varint::decode(buffer.vector.data() + buffer.read_position, buffer.vector.size() - buffer.read_position, result);
+
+        if(count) {
+            buffer.read_position += count;
+            return result;
+        }
     }
 
-    buffer.read_position += 8U;
+    buffer.read_position = cxpr::max(buffer.read_position, buffer.vector.size()) + 1U;
     return UINT64_C(0);
 }
 
-std::string RWBuffer::read_string(RWBuffer &buffer)
+std::int64_t RWBuffer::read_VI64(RWBuffer &buffer)
 {
-    std::size_t size = RWBuffer::read_UI16(buffer);
-    std::string result = std::string();
+    return varint::unzigzag(RWBuffer::read_VUI64(buffer));
+}
 
-    for(std::size_t i = 0; i < size; ++i) {
-        if(buffer.read_position < buffer.vector.size())
-            result.push_back(static_cast<char>(buffer.vector[buffer.read_position]));
-        buffer.read_position += 1U;
+std::string RWBuffer::read_vstring(RWBuffer &buffer)
+{
+    return std::string(RWBuffer::read_vstring_view(buffer));
+}
+
+std::string_view RWBuffer::read_vstring_view(RWBuffer &buffer)
+{
+    const std::uint64_t size = RWBuffer::read_VUI64(buffer);
+
+    if constexpr(SIZE_MAX < UINT64_MAX) {
+        if(size > SIZE_MAX) {
+            buffer.read_position = buffer.vector.size() + 1;
+            return std::string_view();
+        }
     }
 
-    return result;
+    return read_string_data(buffer, static_cast<std::size_t>(size));
+}
+
+void RWBuffer::read_bytes(RWBuffer &buffer, void *data, std::size_t size)
+{
+    std::size_t available = 0;
+
+    if(buffer.read_position < buffer.vector.size())
+        available = std::min(size, buffer.vector.size() - buffer.read_position);
+    if(available != 0)
+        std::memcpy(data, buffer.vector.data() + buffer.read_position, available);
+    if(available != size)
+        std::memset(reinterpret_cast<std::byte *>(data) + available, 0, size - available);
+    buffer.read_position += size;
+}
+
+void RWBuffer::read_FP32_array(RWBuffer &buffer, float *values, std::size_t count)
+{
+    read_big_array<float, std::uint32_t>(buffer, values, count);
+}
+
+void RWBuffer::read_UI16_array(RWBuffer &buffer, std::uint16_t *values, std::size_t count)
+{
+    read_big_array(buffer, values, count);
+}
+
+void RWBuffer::read_UI32_array(RWBuffer &buffer, std::uint32_t *values, std::size_t count)
+{
+    read_big_array(buffer, values, count);
+}
+
+void RWBuffer::read_UI64_array(RWBuffer &buffer, std::uint64_t *values, std::size_t count)
+{
+    read_big_array(buffer, values, count);
 }
 
 void RWBuffer::write_FP32(RWBuffer &buffer, float value)
@@ -137,35 +246,73 @@ void RWBuffer::write_UI8(RWBuffer &buffer, std::uint8_t value)
 
 void RWBuffer::write_UI16(RWBuffer &buffer, std::uint16_t value)
 {
-    buffer.vector.push_back(static_cast<std::byte>((value & UINT16_C(0xFF00)) >> 8U));
-    buffer.vector.push_back(static_cast<std::byte>((value & UINT16_C(0x00FF)) >> 0U));
+    byteorder::store_big<std::uint16_t>(append(buffer, sizeof(value)), value);
 }
 
 void RWBuffer::write_UI32(RWBuffer &buffer, std::uint32_t value)
 {
-    buffer.vector.push_back(static_cast<std::byte>((value & UINT32_C(0xFF000000)) >> 24U));
-    buffer.vector.push_back(static_cast<std::byte>((value & UINT32_C(0x00FF0000)) >> 16U));
-    buffer.vector.push_back(static_cast<std::byte>((value & UINT32_C(0x0000FF00)) >> 8U));
-    buffer.vector.push_back(static_cast<std::byte>((value & UINT32_C(0x000000FF)) >> 0U));
+    byteorder::store_big<std::uint32_t>(append(buffer, sizeof(value)), value);
 }
 
 void RWBuffer::write_UI64(RWBuffer &buffer, std::uint64_t value)
 {
-    buffer.vector.push_back(static_cast<std::byte>((value & UINT64_C(0xFF00000000000000)) >> 56U));
-    buffer.vector.push_back(static_cast<std::byte>((value & UINT64_C(0x00FF000000000000)) >> 48U));
-    buffer.vector.push_back(static_cast<std::byte>((value & UINT64_C(0x0000FF0000000000)) >> 40U));
-    buffer.vector.push_back(static_cast<std::byte>((value & UINT64_C(0x000000FF00000000)) >> 32U));
-    buffer.vector.push_back(static_cast<std::byte>((value & UINT64_C(0x00000000FF000000)) >> 24U));
-    buffer.vector.push_back(static_cast<std::byte>((value & UINT64_C(0x0000000000FF0000)) >> 16U));
-    buffer.vector.push_back(static_cast<std::byte>((value & UINT64_C(0x000000000000FF00)) >> 8U));
-    buffer.vector.push_back(static_cast<std::byte>((value & UINT64_C(0x00000000000000FF)) >> 0U));
+    byteorder::store_big<std::uint64_t>(append(buffer, sizeof(value)), value);
 }
 
 void RWBuffer::write_string(RWBuffer &buffer, const std::string &value)
 {
     const std::size_t size = cxpr::min<std::size_t>(UINT16_MAX, value.size());
-    RWBuffer::write_UI16(buffer, static_cast<std::uint16_t>(size));
-    for(std::size_t i = 0; i < size; RWBuffer::write_UI8(buffer, value[i++]));
+    auto data = append(buffer, sizeof(std::uint16_t) + size);
+    byteorder::store_big<std::uint16_t>(data, static_cast<std::uint16_t>(size));
+    std::memcpy(data + sizeof(std::uint16_t), value.data(), size);
+}
+
+void RWBuffer::write_VUI64(RWBuffer &buffer, std::uint64_t value)
+{
+    std::byte data[VARINT_MAX_SIZE];
+    RWBuffer::write_bytes(buffer, data, varint::encode(value, data));
+}
+
+void RWBuffer::write_VI64(RWBuffer &buffer, std::int64_t value)
+{
+    RWBuffer::write_VUI64(buffer, varint::zigzag(value));
+}
+
+void RWBuffer::write_vstring(RWBuffer &buffer, std::string_view value)
+{
+    std::byte prefix[VARINT_MAX_SIZE];
+    const std::size_t prefix_size = varint::encode(value.size(), prefix);
+
+    auto data = append(buffer, prefix_size + value.size());
+    std::memcpy(data, prefix, prefix_size);
+    std::memcpy(data + prefix_size, value.data(), value.size());
+}
+
+void RWBuffer::write_bytes(RWBuffer &buffer, const void *data, std::size_t size)
+{
+    if(size != 0) {
+        std::memcpy(append(buffer, size), data, size);
+    }
+}
+
+void RWBuffer::write_FP32_array(RWBuffer &buffer, const float *values, std::size_t count)
+{
+    write_big_array<float, std::uint32_t>(buffer, values, count);
+}
+
+void RWBuffer::write_UI16_array(RWBuffer &buffer, const std::uint16_t *values, std::size_t count)
+{
+    write_big_array(buffer, values, count);
+}
+
+void RWBuffer::write_UI32_array(RWBuffer &buffer, const std::uint32_t *values, std::size_t count)
+{
+    write_big_array(buffer, values, count);
+}
+
+void RWBuffer::write_UI64_array(RWBuffer &buffer, const std::uint64_t *values, std::size_t count)
+{
+    write_big_array(buffer, values, count);
 }
 
 void RWBuffer::setup(RWBuffer &buffer)
@@ -174,6 +321,13 @@ void RWBuffer::setup(RWBuffer &buffer)
     buffer.vector.clear();
 }
 
+void RWBuffer::setup(RWBuffer &buffer, std::size_t size_hint)
+{
+    buffer.read_position = 0;
+    buffer.vector.clear();
+    buffer.vector.reserve(size_hint);
+}
+
 void RWBuffer::setup(RWBuffer &buffer, const void *data, std::size_t size)
 {
     auto data_ptr = reinterpret_cast<const std::byte *>(data);
@@ -21,7 +21,54 @@ public:
     static std::uint32_t read_UI32(RWBuffer &buffer);
     static std::uint64_t read_UI64(RWBuffer &buffer);
     static std::string read_string(RWBuffer &buffer);
-    
+
+    /**
+     * Reads a string without copying it
+     * @param buffer The buffer
+     * @returns A view into the buffer's storage; if the string
+     * is truncated, an empty view is returned and the read
+     * position moves past the end
+     * @note Writing into the buffer invalidates the result
+     */
+    static std::string_view read_string_view(RWBuffer &buffer);
+
+public:
+    /**
+     * Reads an LEB128 unsigned varint; a truncated or
+     * malformed varint reads as zero and moves the read
+     * position past the end of the buffer
+     * @param buffer The buffer
+     */
+    static std::uint64_t read_VUI64(RWBuffer &buffer);
+
+    /**
+     * Reads a zigzag-encoded signed varint
+     * @param buffer The buffer
+     */
+    static std::int64_t read_VI64(RWBuffer &buffer);
+
+    /**
+     * Reads a string prefixed with a varint size
+     * @param buffer The buffer
+     */
+    static std::string read_vstring(RWBuffer &buffer);
+    static std::string_view read_vstring_view(RWBuffer &buffer);
+
+public:
+    /**
+     * Reads raw bytes; bytes past the end
+     * of the buffer are read as zeroes
+     * @param buffer The buffer
+     * @param data Destination memory
+     * @param size Amount of bytes to read
+     */
+    static void read_bytes(RWBuffer &buffer, void *data, std::size_t size);
+
+    static void read_FP32_array(RWBuffer &buffer, float *values, std::size_t count);
+    static void read_UI16_array(RWBuffer &buffer, std::uint16_t *values, std::size_t count);
+    static void read_UI32_array(RWBuffer &buffer, std::uint32_t *values, std::size_t count);
+    static void read_UI64_array(RWBuffer &buffer, std::uint64_t *values, std::size_t count);
+
 public:
     static void write_FP32(RWBuffer &buffer, float value);
     static void write_I8(RWBuffer &buffer, std::int8_t value);
@@ -34,6 +81,45 @@ public:
     static void write_UI64(RWBuffer &buffer, std::uint64_t value);
     static void write_string(RWBuffer &buffer, const std::string &value);
 
+public:
+    /**
+     * Writes an LEB128 unsigned varint; values
+     * below 128 take a single byte, full 64-bit values
+     * take up to VARINT_MAX_SIZE bytes
+     * @param buffer The buffer
+     * @param value The value
+     */
+    static void write_VUI64(RWBuffer &buffer, std::uint64_t value);
+
+    /**
+     * Writes a zigzag-encoded signed varint
+     * @param buffer The buffer
+     * @param value The value
+     */
+    static void write_VI64(RWBuffer &buffer, std::int64_t value);
+
+    /**
+     * Writes a string prefixed with a varint size
+     * instead of the fixed UI16 that write_string uses
+     * @param buffer The buffer
+     * @param value The value
+     */
+    static void write_vstring(RWBuffer &buffer, std::string_view value);
+
+public:
+    /**
+     * Writes raw bytes
+     * @param buffer The buffer
+     * @param data Source memory
+     * @param size Amount of bytes to write
+     */
+    static void write_bytes(RWBuffer &buffer, const void *data, std::size_t size);
+
+    static void write_FP32_array(RWBuffer &buffer, const float *values, std::size_t count);
+    static void write_UI16_array(RWBuffer &buffer, const std::uint16_t *values, std::size_t count);
+    static void write_UI32_array(RWBuffer &buffer, const std::uint32_t *values, std::size_t count);
+    static void write_UI64_array(RWBuffer &buffer, const std::uint64_t *values, std::size_t count);
+
 public:
     /**
      * Setup a buffer for writing
@@ -41,6 +127,14 @@ public:
      */
     static void setup(RWBuffer &buffer);
 
+    /**
+     * Setup a buffer for writing and reserve storage
+     * in advance so the following writes don't reallocate
+     * @param buffer The buffer
+     * @param size_hint Expected amount of bytes to be written
+     */
+    static void setup(RWBuffer &buffer, std::size_t size_hint);
+
     /**
      * Setup a buffer for reading
      * @param buffer The buffer
@@ -0,0 +1,133 @@
+#include "core/precompiled.hh"
+#include "core/rwpool.hh"
+
+#include "core/config.hh"
+#include "core/logging.hh"
+#include "core/memtrack.hh"
+#include "core/profiler.hh"
+#include "core/rwbuffer.hh"
+
+// Initial size of each pooled buffer's storage
+static ConfigHandle<std::size_t> buffer_size;
+
+// Buffers that grow larger than this are shrunk
+// back down when released so that one huge message
+// doesn't pin its memory for the rest of the session
+static ConfigHandle<std::size_t> buffer_max_size;
+
+// Amount of buffers allocated up-front
+static ConfigHandle<std::size_t> prealloc_count;
+
+static std::mutex pool_mutex;
+static std::vector<RWBuffer *> free_list;
+static std::size_t num_total = 0;
+static std::size_t frame_hits = 0;
+static std::size_t frame_misses = 0;
+static RWPoolStats last_stats = {};
+
+void rwpool::init(void)
+{
+    buffer_size = config::add<std::size_t>("rwpool.buffer_size", 1536);
+    buffer_max_size = config::add<std::size_t>("rwpool.buffer_max_size", 65536);
+    prealloc_count = config::add<std::size_t>("rwpool.prealloc_count", 64);
+}
+
+void rwpool::init_late(void)
+{
+    QF_memory_tag(MEMTAG_NETWORK);
+
+    std::lock_guard<std::mutex> lock(pool_mutex);
+
+    const std::size_t count = config::get(prealloc_count);
+    const std::size_t size = config::get(buffer_size);
+
+    free_list.reserve(count);
+
+    while(free_list.size() < count) {
+        auto buffer = new RWBuffer();
+        RWBuffer::setup(*buffer, size);
+        free_list.push_back(buffer);
+        num_total += 1;
+    }
+
+    QF_verbose("rwpool: %zu buffers of %zu bytes", free_list.size(), size);
+}
+
+void rwpool::deinit(void)
+{
+    std::lock_guard<std::mutex> lock(pool_mutex);
+
+    if(free_list.size() != num_total)
+        QF_warning("rwpool: %zu buffers were never released", num_total - free_list.size());
+    for(auto buffer : free_list)
+        delete buffer;
+
+    num_total = 0;
+    free_list.clear();
+    free_list.shrink_to_fit();
+}
+
+RWBuffer *rwpool::acquire(void)
+{
+    QF_memory_tag(MEMTAG_NETWORK);
+
+    std::unique_lock<std::mutex> lock(pool_mutex);
+
+    if(!free_list.empty()) {
+        auto buffer = free_list.back();
+        free_list.pop_back();
+        frame_hits += 1;
+        return buffer;
+    }
+
+    frame_misses += 1;
+    num_total += 1;
+
+    // Don't hold the lock while hitting the heap
+    lock.unlock();
+
+    auto buffer = new RWBuffer();
+    RWBuffer::setup(*buffer, config::get(buffer_size));
+    return buffer;
+}
+
+void rwpool::release(RWBuffer *buffer)
+{
+    QF_memory_tag(MEMTAG_NETWORK);
+
+    if(buffer == nullptr)
+        return;
+
+    if(buffer->vector.capacity() > config::get(buffer_max_size)) {
+        buffer->vector = std::vector<std::byte>();
+        buffer->vector.reserve(config::get(buffer_size));
+    }
+
+    RWBuffer::setup(*buffer);
+
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    free_list.push_back(buffer);
+}
+
+void rwpool::update_frame(void)
+{
+    QF_profile_zone("rwpool::update_frame");
+
+    std::lock_guard<std::mutex> lock(pool_mutex);
+
+    last_stats.hits = frame_hits;
+    last_stats.misses = frame_misses;
+    last_stats.num_free = free_list.size();
+    last_stats.num_total = num_total;
+
+    QF_profile_counter("rwpool.misses", frame_misses);
+
+    frame_hits = 0;
+    frame_misses = 0;
+}
+
+RWPoolStats rwpool::get_stats(void)
+{
+    std::lock_guard<std::mutex> lock(pool_mutex);
+    return last_stats;
+}
@@ -0,0 +1,71 @@
+#ifndef CORE_RWPOOL_HH
+#define CORE_RWPOOL_HH 1
+#pragma once
+
+class RWBuffer;
+
+/**
+ * Pool usage counters; hits and misses
+ * are tracked per frame, see rwpool::update_frame
+ */
+struct RWPoolStats final {
+    std::size_t hits;           ///< Acquisitions served from the free list
+    std::size_t misses;         ///< Acquisitions that had to allocate
+    std::size_t num_free;       ///< Buffers sitting in the free list
+    std::size_t num_total;      ///< Buffers owned by the pool
+};
+
+namespace rwpool
+{
+/**
+ * Registers pool config variables
+ */
+void init(void);
+
+/**
+ * Pre-allocates pooled buffers; should be
+ * called after the config files are loaded
+ */
+void init_late(void);
+
+/**
+ * Frees all pooled buffers
+ * @warning Buffers that are still acquired
+ * at this point are leaked and reported
+ */
+void deinit(void);
+} // namespace rwpool
+
+namespace rwpool
+{
+/**
+ * Hands out a buffer set up for writing with
+ * its storage already reserved; thread-safe
+ * @returns A buffer owned by the pool
+ */
+RWBuffer *acquire(void);
+
+/**
+ * Returns a buffer into the pool; thread-safe
+ * @param buffer A buffer obtained with rwpool::acquire
+ */
+void release(RWBuffer *buffer);
+} // namespace rwpool
+
+namespace rwpool
+{
+/**
+ * Finishes a frame worth of pool statistics;
+ * the frame's counters become the ones returned
+ * by rwpool::get_stats and new counters start
+ */
+void update_frame(void);
+
+/**
+ * Figure out pool usage over the previous frame
+ * @returns Pool statistics
+ */
+RWPoolStats get_stats(void);
+} // namespace rwpool
+
+#endif /* CORE_RWPOOL_HH */
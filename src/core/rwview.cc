@@ -0,0 +1,202 @@
+#include "core/precompiled.hh"
+#include "core/rwview.hh"
+
+#include "core/byteorder.hh"
+#include "core/constexpr.hh"
+#include "core/floathacks.hh"
+#include "core/rwbuffer.hh"
+#include "core/varint.hh"
+
+template<typename T>
+static inline T read_big(RWView &view)
+{
+    if((view.read_position + sizeof(T)) <= view.size) {
+        auto result = byteorder::load_big<T>(view.data + view.read_position);
+        view.read_position += sizeof(T);
+        return result;
+    }
+
+    view.read_position += sizeof(T);
+    return T(0);
+}
+
+// Arrays are processed as raw memory with the byte order
+// fixed up in-place; U is an unsigned integer type matching T
+template<typename T, typename U = T>
+static inline void read_big_array(RWView &view, T *values, std::size_t count)
+{
+    static_assert(sizeof(T) == sizeof(U));
+    RWView::read_bytes(view, values, count * sizeof(T));
+
+    if constexpr(!QF_BIG_ENDIAN) {
+        auto data = reinterpret_cast<std::byte *>(values);
+        for(std::size_t i = 0; i < count; ++i) {
+            auto value = byteorder::load_big<U>(data + i * sizeof(T));
+            std::memcpy(data + i * sizeof(T), &value, sizeof(T));
+        }
+    }
+}
+
+// Strings may be truncated, in which case only the part
+// that is actually present in the data is returned
+static std::string_view read_string_data(RWView &view, std::size_t size)
+{
+    std::size_t start = view.read_position;
+
+    // Lengths come straight off the wire; one past
+    // the end of the data doesn't fit a wrapping addition
+    // and still marks the reader as having run out of data
+    if((start > view.size) || (size > view.size - start)) {
+        view.read_position = view.size + 1;
+        return std::string_view();
+    }
+
+    view.read_position += size;
+
+    if(size == 0)
+        return std::string_view();
+    return std::string_view(reinterpret_cast<const char *>(view.data + start), size);
+}
+
+float RWView::read_FP32(RWView &view)
+{
+    return floathacks::uint32_to_float(RWView::read_UI32(view));
+}
+
+std::int8_t RWView::read_I8(RWView &view)
+{
+    return static_cast<std::int8_t>(RWView::read_UI8(view));
+}
+
+std::int16_t RWView::read_I16(RWView &view)
+{
+    return static_cast<std::int16_t>(RWView::read_UI16(view));
+}
+
+std::int32_t RWView::read_I32(RWView &view)
+{
+    return static_cast<std::int32_t>(RWView::read_UI32(view));
+}
+
+std::int64_t RWView::read_I64(RWView &view)
+{
+    return static_cast<std::int64_t>(RWView::read_UI64(view));
+}
+
+std::uint8_t RWView::read_UI8(RWView &view)
+{
+    return read_big<std::uint8_t>(view);
+}
+
+std::uint16_t RWView::read_UI16(RWView &view)
+{
+    return read_big<std::uint16_t>(view);
+}
+
+std::uint32_t RWView::read_UI32(RWView &view)
+{
+    return read_big<std::uint32_t>(view);
+}
+
+std::uint64_t RWView::read_UI64(RWView &view)
+{
+    return read_big<std::uint64_t>(view);
+}
+
+std::string RWView::read_string(RWView &view)
+{
+    return std::string(RWView::read_string_view(view));
+}
+
+std::string_view RWView::read_string_view(RWView &view)
+{
+    return read_string_data(view, RWView::read_UI16(view));
+}
+
+std::uint64_t RWView::read_VUI64(RWView &view)
+{
+    std::uint64_t result = UINT64_C(0);
+
+    if(view.read_position < view.size) {
+        auto count = varint::decode(view.data + view.read_position, view.size - view.read_position, result);
+
+        if(count) {
+            view.read_position += count;
+            return result;
+        }
+    }
+
+    view.read_position = cxpr::max(view.read_position, view.size) + 1U;
+    return UINT64_C(0);
+}
+
+std::int64_t RWView::read_VI64(RWView &view)
+{
+    return varint::unzigzag(RWView::read_VUI64(view));
+}
+
+std::string RWView::read_vstring(RWView &view)
+{
+    return std::string(RWView::read_vstring_view(view));
+}
+
+std::string_view RWView::read_vstring_view(RWView &view)
+{
+    const std::uint64_t size = RWView::read_VUI64(view);
+
+    if constexpr(SIZE_MAX < UINT64_MAX) {
+        if(size > SIZE_MAX) {
+            view.read_position = view.size + 1;
+            return std::string_view();
+        }
+    }
+
+    return read_string_data(view, static_cast<std::size_t>(size));
+}
+
+void RWView::read_bytes(RWView &view, void *data, std::size_t size)
+{
+    std::size_t available = 0;
+
+    if(view.read_position < view.size)
+        available = std::min(size, view.size - view.read_position);
+    if(available != 0)
+        std::memcpy(data, view.data + view.read_position, available);
+    if(available != size)
+        std::memset(reinterpret_cast<std::byte *>(data) + available, 0, size - available);
+    view.read_position += size;
+}
+
+void RWView::read_FP32_array(RWView &view, float *values, std::size_t count)
+{
+    read_big_array<float, std::uint32_t>(view, values, count);
+}
+
+void RWView::read_UI16_array(RWView &view, std::uint16_t *values, std::size_t count)
+{
+    read_big_array(view, values, count);
+}
+
+void RWView::read_UI32_array(RWView &view, std::uint32_t *values, std::size_t count)
+{
+    read_big_array(view, values, count);
+}
+
+void RWView::read_UI64_array(RWView &view, std::uint64_t *values, std::size_t count)
+{
+    read_big_array(view, values, count);
+}
+
+void RWView::setup(RWView &view, const void *data, std::size_t size)
+{
+    view.data = reinterpret_cast<const std::byte *>(data);
+    view.size = size;
+    view.read_position = 0;
+}
+
+void RWView::setup(RWView &view, const RWBuffer &buffer)
+{
+    view.data = buffer.vector.data();
+    view.size = buffer.vector.size();
+    view.read_position = 0;
+}
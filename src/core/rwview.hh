@@ -0,0 +1,97 @@
+#ifndef CORE_RWVIEW_HH
+#define CORE_RWVIEW_HH 1
+#pragma once
+
+class RWBuffer;
+
+/**
+ * A non-owning read-only view over a chunk of memory;
+ * this has the same reading semantics as RWBuffer but
+ * never copies the data, so packets and loaded files
+ * can be parsed in-place without any heap allocations
+ * @note The viewed memory must outlive the view itself
+ */
+class RWView final {
+public:
+    std::size_t read_position;
+    std::size_t size;
+    const std::byte *data;
+
+public:
+    static float read_FP32(RWView &view);
+    static std::int8_t read_I8(RWView &view);
+    static std::int16_t read_I16(RWView &view);
+    static std::int32_t read_I32(RWView &view);
+    static std::int64_t read_I64(RWView &view);
+    static std::uint8_t read_UI8(RWView &view);
+    static std::uint16_t read_UI16(RWView &view);
+    static std::uint32_t read_UI32(RWView &view);
+    static std::uint64_t read_UI64(RWView &view);
+    static std::string read_string(RWView &view);
+
+    /**
+     * Reads a string without copying it
+     * @param view The view
+     * @returns A view into the underlying memory; if the string
+     * is truncated, an empty view is returned and the read
+     * position moves past the end
+     * @note The result is only valid as long as the viewed memory is
+     */
+    static std::string_view read_string_view(RWView &view);
+
+public:
+    /**
+     * Reads an LEB128 unsigned varint; a truncated or
+     * malformed varint reads as zero and moves the read
+     * position past the end of the view
+     * @param view The view
+     */
+    static std::uint64_t read_VUI64(RWView &view);
+
+    /**
+     * Reads a zigzag-encoded signed varint
+     * @param view The view
+     */
+    static std::int64_t read_VI64(RWView &view);
+
+    /**
+     * Reads a string prefixed with a varint size
+     * @param view The view
+     */
+    static std::string read_vstring(RWView &view);
+    static std::string_view read_vstring_view(RWView &view);
+
+public:
+    /**
+     * Reads raw bytes; bytes past the end
+     * of the view are read as zeroes
+     * @param view The view
+     * @param data Destination memory
+     * @param size Amount of bytes to read
+     */
+    static void read_bytes(RWView &view, void *data, std::size_t size);
+
+    static void read_FP32_array(RWView &view, float *values, std::size_t count);
+    static void read_UI16_array(RWView &view, std::uint16_t *values, std::size_t count);
+    static void read_UI32_array(RWView &view, std::uint32_t *values, std::size_t count);
+    static void read_UI64_array(RWView &view, std::uint64_t *values, std::size_t count);
+
+public:
+    /**
+     * Setup a view for reading
+     * @param view The view
+     * @param data The data to read from
+     * @param size The data size in bytes
+     */
+    static void setup(RWView &view, const void *data, std::size_t size);
+
+    /**
+     * Setup a view for reading the contents of a buffer
+     * @param view The view
+     * @param buffer The buffer to read from
+     * @note Writing into the buffer invalidates the view
+     */
+    static void setup(RWView &view, const RWBuffer &buffer);
+};
+
+#endif /* CORE_RWVIEW_HH */
@@ -0,0 +1,351 @@
+#ifndef CORE_SERIAL_HH
+#define CORE_SERIAL_HH 1
+#pragma once
+
+#include "core/floathacks.hh"
+#include "core/rwbuffer.hh"
+#include "core/varint.hh"
+
+namespace serial
+{
+/**
+ * A compile-time list of serialized fields
+ * @tparam M Pointers to members in the order they go on the wire
+ */
+template<auto... M>
+struct Fields final {
+    constexpr static std::size_t count = sizeof...(M);
+};
+
+/**
+ * Describes a serializable struct; specializations
+ * declare `using fields = serial::Fields<...>`
+ * @code{.cpp}
+ * template<>
+ * struct serial::Describe<ClientCommand> final {
+ *     using fields = serial::Fields<&ClientCommand::wishdir, &ClientCommand::angles, &ClientCommand::keys>;
+ * };
+ * @endcode
+ */
+template<typename T>
+struct Describe;
+
+/**
+ * Encodes and decodes values of a single type; specializations
+ * provide `max_size`, `equal`, `write` and a templated `read` that
+ * accepts anything with RWBuffer-like static read functions (RWView)
+ */
+template<typename T, typename = void>
+struct Codec;
+} // namespace serial
+
+namespace serial
+{
+/**
+ * Writes all described fields of a value
+ * @param buffer The buffer
+ * @param value The value
+ */
+template<typename T>
+static inline void encode(RWBuffer &buffer, const T &value);
+
+/**
+ * Reads all described fields of a value
+ * @param reader RWBuffer or RWView
+ * @param value The value
+ */
+template<typename T, typename R>
+static inline void decode(R &reader, T &value);
+
+/**
+ * Writes a mask of fields that differ from `base`
+ * followed by the values of those fields only
+ * @param buffer The buffer
+ * @param base The value the receiving end already has
+ * @param value The value
+ * @note Described structs may have at most 64 fields
+ */
+template<typename T>
+static inline void delta_encode(RWBuffer &buffer, const T &base, const T &value);
+
+/**
+ * Reads a delta written with serial::delta_encode
+ * @param reader RWBuffer or RWView
+ * @param base The value the delta was made against
+ * @param value The value; fields absent from the delta are copied from `base`
+ */
+template<typename T, typename R>
+static inline void delta_decode(R &reader, const T &base, T &value);
+
+/**
+ * Figure out the encoded size upper bound
+ * @returns Maximum size of serial::encode output in bytes
+ */
+template<typename T>
+constexpr static inline std::size_t max_size(void);
+
+/**
+ * Figure out the delta-encoded size upper bound
+ * @returns Maximum size of serial::delta_encode output in bytes
+ */
+template<typename T>
+constexpr static inline std::size_t max_delta_size(void);
+} // namespace serial
+
+namespace serial
+{
+template<typename T>
+struct MemberType;
+
+template<typename C, typename V>
+struct MemberType<V C::*> final {
+    using type = V;
+};
+
+template<auto M>
+using member_t = typename MemberType<decltype(M)>::type;
+
+template<typename T, typename = void>
+struct IsDescribed final : std::false_type {};
+
+template<typename T>
+struct IsDescribed<T, std::void_t<typename Describe<T>::fields>> final : std::true_type {};
+} // namespace serial
+
+template<typename T>
+struct serial::Codec<T, std::enable_if_t<std::is_integral_v<T> && !std::is_same_v<T, bool>>> final {
+    using U = std::make_unsigned_t<T>;
+    constexpr static std::size_t max_size = sizeof(T);
+
+    static inline bool equal(const T a, const T b)
+    {
+        return a == b;
+    }
+
+    static inline void write(RWBuffer &buffer, const T value)
+    {
+        if constexpr(sizeof(T) == 1)
+            RWBuffer::write_UI8(buffer, static_cast<std::uint8_t>(static_cast<U>(value)));
+        else if constexpr(sizeof(T) == 2)
+            RWBuffer::write_UI16(buffer, static_cast<std::uint16_t>(static_cast<U>(value)));
+        else if constexpr(sizeof(T) == 4)
+            RWBuffer::write_UI32(buffer, static_cast<std::uint32_t>(static_cast<U>(value)));
+        else RWBuffer::write_UI64(buffer, static_cast<std::uint64_t>(static_cast<U>(value)));
+    }
+
+    template<typename R>
+    static inline void read(R &reader, T &value)
+    {
+        if constexpr(sizeof(T) == 1)
+            value = static_cast<T>(R::read_UI8(reader));
+        else if constexpr(sizeof(T) == 2)
+            value = static_cast<T>(R::read_UI16(reader));
+        else if constexpr(sizeof(T) == 4)
+            value = static_cast<T>(R::read_UI32(reader));
+        else value = static_cast<T>(R::read_UI64(reader));
+    }
+};
+
+template<typename T>
+struct serial::Codec<T, std::enable_if_t<std::is_enum_v<T>>> final {
+    using I = std::underlying_type_t<T>;
+    constexpr static std::size_t max_size = serial::Codec<I>::max_size;
+
+    static inline bool equal(const T a, const T b)
+    {
+        return a == b;
+    }
+
+    static inline void write(RWBuffer &buffer, const T value)
+    {
+        serial::Codec<I>::write(buffer, static_cast<I>(value));
+    }
+
+    template<typename R>
+    static inline void read(R &reader, T &value)
+    {
+        I underlying;
+        serial::Codec<I>::read(reader, underlying);
+        value = static_cast<T>(underlying);
+    }
+};
+
+template<>
+struct serial::Codec<bool> final {
+    constexpr static std::size_t max_size = 1;
+
+    static inline bool equal(const bool a, const bool b)
+    {
+        return a == b;
+    }
+
+    static inline void write(RWBuffer &buffer, const bool value)
+    {
+        RWBuffer::write_UI8(buffer, value ? 1U : 0U);
+    }
+
+    template<typename R>
+    static inline void read(R &reader, bool &value)
+    {
+        value = R::read_UI8(reader) != 0U;
+    }
+};
+
+template<>
+struct serial::Codec<float> final {
+    constexpr static std::size_t max_size = sizeof(float);
+
+    // Compare bit patterns so that NaNs don't
+    // end up being re-sent with every single delta
+    static inline bool equal(const float a, const float b)
+    {
+        return floathacks::float_to_uint32(a) == floathacks::float_to_uint32(b);
+    }
+
+    static inline void write(RWBuffer &buffer, const float value)
+    {
+        RWBuffer::write_FP32(buffer, value);
+    }
+
+    template<typename R>
+    static inline void read(R &reader, float &value)
+    {
+        value = R::read_FP32(reader);
+    }
+};
+
+template<glm::length_t L, glm::qualifier Q>
+struct serial::Codec<glm::vec<L, float, Q>> final {
+    using V = glm::vec<L, float, Q>;
+    constexpr static std::size_t max_size = L * sizeof(float);
+
+    static inline bool equal(const V &a, const V &b)
+    {
+        for(glm::length_t i = 0; i < L; ++i) {
+            if(!serial::Codec<float>::equal(a[i], b[i]))
+                return false;
+        }
+
+        return true;
+    }
+
+    static inline void write(RWBuffer &buffer, const V &value)
+    {
+        RWBuffer::write_FP32_array(buffer, &value[0], L);
+    }
+
+    template<typename R>
+    static inline void read(R &reader, V &value)
+    {
+        R::read_FP32_array(reader, &value[0], L);
+    }
+};
+
+template<typename T>
+struct serial::Codec<T, std::enable_if_t<serial::IsDescribed<T>::value>> final {
+    using F = typename serial::Describe<T>::fields;
+    constexpr static std::size_t max_size = serial::max_size<T>();
+
+    static inline bool equal(const T &a, const T &b)
+    {
+        return equal_fields(a, b, F());
+    }
+
+    static inline void write(RWBuffer &buffer, const T &value)
+    {
+        serial::encode(buffer, value);
+    }
+
+    template<typename R>
+    static inline void read(R &reader, T &value)
+    {
+        serial::decode(reader, value);
+    }
+
+private:
+    template<auto... M>
+    static inline bool equal_fields(const T &a, const T &b, serial::Fields<M...>)
+    {
+        return (serial::Codec<serial::member_t<M>>::equal(a.*M, b.*M) && ...);
+    }
+};
+
+namespace serial
+{
+template<typename T, auto... M>
+static inline void encode_fields(RWBuffer &buffer, const T &value, Fields<M...>)
+{
+    (Codec<member_t<M>>::write(buffer, value.*M), ...);
+}
+
+template<typename T, typename R, auto... M>
+static inline void decode_fields(R &reader, T &value, Fields<M...>)
+{
+    (Codec<member_t<M>>::read(reader, value.*M), ...);
+}
+
+template<typename T, auto... M, std::size_t... I>
+static inline void delta_encode_fields(RWBuffer &buffer, const T &base, const T &value, Fields<M...>, std::index_sequence<I...>)
+{
+    std::uint64_t mask = UINT64_C(0);
+    ((mask |= Codec<member_t<M>>::equal(base.*M, value.*M) ? UINT64_C(0) : (UINT64_C(1) << I)), ...);
+
+    RWBuffer::write_VUI64(buffer, mask);
+    ((mask & (UINT64_C(1) << I) ? Codec<member_t<M>>::write(buffer, value.*M) : void()), ...);
+}
+
+template<typename T, typename R, auto... M, std::size_t... I>
+static inline void delta_decode_fields(R &reader, const T &base, T &value, Fields<M...>, std::index_sequence<I...>)
+{
+    const std::uint64_t mask = R::read_VUI64(reader);
+    ((mask & (UINT64_C(1) << I) ? Codec<member_t<M>>::read(reader, value.*M) : void(value.*M = base.*M)), ...);
+}
+
+template<auto... M>
+constexpr static inline std::size_t max_size_fields(Fields<M...>)
+{
+    return (std::size_t(0) + ... + Codec<member_t<M>>::max_size);
+}
+} // namespace serial
+
+template<typename T>
+static inline void serial::encode(RWBuffer &buffer, const T &value)
+{
+    serial::encode_fields(buffer, value, typename serial::Describe<T>::fields());
+}
+
+template<typename T, typename R>
+static inline void serial::decode(R &reader, T &value)
+{
+    serial::decode_fields(reader, value, typename serial::Describe<T>::fields());
+}
+
+template<typename T>
+static inline void serial::delta_encode(RWBuffer &buffer, const T &base, const T &value)
+{
+    using F = typename serial::Describe<T>::fields;
+    static_assert(F::count <= 64, "delta masks are limited to 64 fields");
+    serial::delta_encode_fields(buffer, base, value, F(), std::make_index_sequence<F::count>());
+}
+
+template<typename T, typename R>
+static inline void serial::delta_decode(R &reader, const T &base, T &value)
+{
+    using F = typename serial::Describe<T>::fields;
+    static_assert(F::count <= 64, "delta masks are limited to 64 fields");
+    serial::delta_decode_fields(reader, base, value, F(), std::make_index_sequence<F::count>());
+}
+
+template<typename T>
+constexpr static inline std::size_t serial::max_size(void)
+{
+    return serial::max_size_fields(typename serial::Describe<T>::fields());
+}
+
+template<typename T>
+constexpr static inline std::size_t serial::max_delta_size(void)
+{
+    return VARINT_MAX_SIZE + serial::max_size<T>();
+}
+
+#endif /* CORE_SERIAL_HH */
@@ -1,11 +1,53 @@
 #include "core/precompiled.hh"
 #include "core/strtools.hh"
 
+#include "core/assert.hh"
+
+#if defined(__x86_64__) || defined(_M_X64)
+#define QF_STRTOOLS_SSE2 1
+#include <emmintrin.h>
+#endif
+
 constexpr static const char *WHITESPACE_CHARS = " \t\r\n";
 
-bool strtools::is_whitespace(const std::string &string)
+static inline bool is_whitespace_char(char c)
+{
+    return (c == ' ') || (c == '\t') || (c == '\r') || (c == '\n');
+}
+
+#if QF_STRTOOLS_SSE2
+static inline unsigned int count_trailing_zeros(unsigned int mask)
+{
+#if defined(_MSC_VER) && !defined(__clang__)
+    unsigned long index;
+    _BitScanForward(&index, mask);
+    return static_cast<unsigned int>(index);
+#else
+    return static_cast<unsigned int>(__builtin_ctz(mask));
+#endif
+}
+
+// Scans 16 bytes at a time; `matcher` produces
+// a byte mask of interesting characters in a block
+template<typename F>
+static inline std::size_t scan_sse2(const char *data, std::size_t size, std::size_t pos, const F &matcher)
 {
-    if(string.find_first_not_of(WHITESPACE_CHARS) == std::string::npos)
+    while(pos + 16 <= size) {
+        const __m128i block = _mm_loadu_si128(reinterpret_cast<const __m128i *>(data + pos));
+        const unsigned int mask = static_cast<unsigned int>(_mm_movemask_epi8(matcher(block)));
+
+        if(mask)
+            return pos + count_trailing_zeros(mask);
+        pos += 16;
+    }
+
+    return pos;
+}
+#endif
+
+bool strtools::is_whitespace(std::string_view string)
+{
+    if(string.find_first_not_of(WHITESPACE_CHARS) == std::string_view::npos)
         return true;
     if((string.size() == 1) && string[0] == 0x00)
         return true;
@@ -28,12 +70,129 @@ std::vector<std::string> strtools::split(const std::string &string, const std::s
     return result;
 }
 
+FrameVector<std::string_view> strtools::split_view(std::string_view string, std::string_view separator)
+{
+    QF_assert(!separator.empty());
+
+    std::size_t pos = 0;
+    std::size_t prev = 0;
+    FrameVector<std::string_view> result;
+
+    while((pos = string.find(separator, prev)) != std::string_view::npos) {
+        result.push_back(string.substr(prev, pos - prev));
+        prev = pos + separator.length();
+    }
+
+    result.push_back(string.substr(prev));
+    return result;
+}
+
 std::string strtools::trim_whitespace(const std::string &string)
 {
-    auto su = string.find_first_not_of(WHITESPACE_CHARS);
-    auto sv = string.find_last_not_of(WHITESPACE_CHARS);
+    return std::string(strtools::trim_whitespace_view(string));
+}
+
+std::string_view strtools::trim_whitespace_view(std::string_view string)
+{
+    std::size_t su = 0;
+    std::size_t sv = string.size();
+
+    while((su < sv) && is_whitespace_char(string[su]))
+        su += 1;
+    while((sv > su) && is_whitespace_char(string[sv - 1]))
+        sv -= 1;
+    return string.substr(su, sv - su);
+}
+
+std::size_t strtools::find_char(std::string_view string, char c, std::size_t pos)
+{
+    if(pos >= string.size())
+        return std::string_view::npos;
+
+#if QF_STRTOOLS_SSE2
+    const __m128i needle = _mm_set1_epi8(c);
+
+    pos = scan_sse2(string.data(), string.size(), pos, [&needle](__m128i block) {
+        return _mm_cmpeq_epi8(block, needle);
+    });
+#endif
+
+    for(; pos < string.size(); ++pos) {
+        if(string[pos] == c) {
+            return pos;
+        }
+    }
+
+    return std::string_view::npos;
+}
+
+std::size_t strtools::find_whitespace(std::string_view string, std::size_t pos)
+{
+    if(pos >= string.size())
+        return std::string_view::npos;
+
+#if QF_STRTOOLS_SSE2
+    const __m128i space = _mm_set1_epi8(' ');
+    const __m128i tab = _mm_set1_epi8('\t');
+    const __m128i cr = _mm_set1_epi8('\r');
+    const __m128i lf = _mm_set1_epi8('\n');
+
+    pos = scan_sse2(string.data(), string.size(), pos, [&](__m128i block) {
+        const __m128i a = _mm_or_si128(_mm_cmpeq_epi8(block, space), _mm_cmpeq_epi8(block, tab));
+        const __m128i b = _mm_or_si128(_mm_cmpeq_epi8(block, cr), _mm_cmpeq_epi8(block, lf));
+        return _mm_or_si128(a, b);
+    });
+#endif
+
+    for(; pos < string.size(); ++pos) {
+        if(is_whitespace_char(string[pos])) {
+            return pos;
+        }
+    }
+
+    return std::string_view::npos;
+}
+
+bool strtools::next_token(std::string_view &string, char separator, std::string_view &token)
+{
+    if(string.data() == nullptr)
+        return false;
+
+    const std::size_t pos = strtools::find_char(string, separator);
+
+    if(pos == std::string_view::npos) {
+        // The last token; a null view marks
+        // the input as completely consumed
+        token = string;
+        string = std::string_view();
+        return true;
+    }
+
+    token = string.substr(0, pos);
+    string.remove_prefix(pos + 1);
+    return true;
+}
+
+bool strtools::next_token(std::string_view &string, std::string_view &token)
+{
+    std::size_t su = 0;
+
+    while((su < string.size()) && is_whitespace_char(string[su]))
+        su += 1;
+    string.remove_prefix(su);
+
+    if(string.empty())
+        return false;
+
+    const std::size_t pos = strtools::find_whitespace(string);
+
+    if(pos == std::string_view::npos) {
+        token = string;
+        string = std::string_view();
+        return true;
+    }
 
-    if(su == std::string::npos)
-        return std::string();
-    return string.substr(su, sv - su + 1);
+    token = string.substr(0, pos);
+    string.remove_prefix(pos + 1);
+    return true;
 }
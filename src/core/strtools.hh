@@ -2,14 +2,26 @@
 #define CORE_STRTOOLS_HH 1
 #pragma once
 
+#include "core/arena.hh"
+
 namespace strtools
 {
-bool is_whitespace(const std::string &string);
+bool is_whitespace(std::string_view string);
 } // namespace strtools
 
 namespace strtools
 {
 std::vector<std::string> split(const std::string &string, const std::string &separator);
+
+/**
+ * Splits a string without copying it; meant for per-frame
+ * code where strtools::split would allocate every token
+ * @param string Input string; must outlive the result
+ * @param separator Separator string, must not be empty
+ * @returns Views into `string` kept in the frame arena
+ * @warning The result must not outlive the frame
+ */
+FrameVector<std::string_view> split_view(std::string_view string, std::string_view separator);
 } // namespace strtools
 
 namespace strtools
@@ -17,4 +29,62 @@ namespace strtools
 std::string trim_whitespace(const std::string &string);
 } // namespace strtools
 
+namespace strtools
+{
+/**
+ * Trims whitespace without copying anything
+ * @param string Input string
+ * @returns A view into `string` without leading
+ * and trailing whitespace characters
+ */
+std::string_view trim_whitespace_view(std::string_view string);
+
+/**
+ * Finds the first occurrence of a character
+ * @param string Input string
+ * @param c Character to look for
+ * @param pos Position to start at
+ * @returns Position of the character or std::string_view::npos
+ */
+std::size_t find_char(std::string_view string, char c, std::size_t pos = 0);
+
+/**
+ * Finds the first whitespace character
+ * @param string Input string
+ * @param pos Position to start at
+ * @returns Position of the character or std::string_view::npos
+ */
+std::size_t find_whitespace(std::string_view string, std::size_t pos = 0);
+} // namespace strtools
+
+namespace strtools
+{
+/**
+ * Splits off the next token delimited by a character;
+ * meant to be used in a loop to walk over a buffer in-place:
+ * @code{.cpp}
+ * std::string_view line;
+ * while(strtools::next_token(source, '\n', line)) {
+ *     // ...
+ * }
+ * @endcode
+ * @param string Remaining input; the token and the
+ * separator are removed from its beginning
+ * @param separator Separator character
+ * @param token The token, not including the separator
+ * @returns false if there was nothing left to split
+ */
+bool next_token(std::string_view &string, char separator, std::string_view &token);
+
+/**
+ * Splits off the next whitespace-delimited token;
+ * consecutive whitespace characters are treated as one
+ * @param string Remaining input; the token and the
+ * whitespace around it are removed from its beginning
+ * @param token The token
+ * @returns false if there were no tokens left
+ */
+bool next_token(std::string_view &string, std::string_view &token);
+} // namespace strtools
+
 #endif /* CORE_STRTOOLS_HH */
@@ -0,0 +1,274 @@
+#include "core/precompiled.hh"
+#include "core/task.hh"
+
+#include "core/jobs.hh"
+#include "core/logging.hh"
+#include "core/profiler.hh"
+
+struct CounterWait final {
+    const JobCounter *counter;
+    std::coroutine_handle<> handle;
+};
+
+static std::thread::id main_thread;
+
+// Tasks resumed by the main thread in tasks::update_frame;
+// tasks queued while it runs wait until the next frame
+static std::mutex main_mutex;
+static std::vector<std::coroutine_handle<>> main_queue;
+static std::vector<CounterWait> counter_waits;
+
+// File reads run on a single dedicated thread
+static std::mutex read_mutex;
+static std::condition_variable read_cv;
+static std::deque<tasks::ReadFile *> read_queue;
+static std::thread read_thread;
+static bool read_shutdown = false;
+
+static void queue_main(std::coroutine_handle<> handle)
+{
+    std::lock_guard<std::mutex> lock(main_mutex);
+    main_queue.push_back(handle);
+}
+
+static void resume_job(void *data, std::size_t)
+{
+    std::coroutine_handle<>::from_address(data).resume();
+}
+
+static void read_contents(tasks::ReadFile &request)
+{
+    request.result.success = false;
+    request.result.contents.clear();
+
+    if(auto file = PHYSFS_openRead(request.path.c_str())) {
+        const PHYSFS_sint64 length = PHYSFS_fileLength(file);
+
+        if(length >= 0) {
+            request.result.contents.resize(static_cast<std::size_t>(length));
+            request.result.success = (PHYSFS_readBytes(file, request.result.contents.data(), length) == length);
+        }
+
+        PHYSFS_close(file);
+    }
+
+    if(!request.result.success) {
+        QF_warning("task: %s: %s", request.path.c_str(), PHYSFS_getErrorByCode(PHYSFS_getLastErrorCode()));
+    }
+}
+
+static void read_main(void)
+{
+    profiler::set_thread_name("file reader");
+
+    while(true) {
+        tasks::ReadFile *request;
+
+        {
+            std::unique_lock<std::mutex> lock(read_mutex);
+            read_cv.wait(lock, [](void) { return read_shutdown || !read_queue.empty(); });
+
+            if(read_queue.empty())
+                break;
+
+            request = read_queue.front();
+            read_queue.pop_front();
+        }
+
+        read_contents(*request);
+
+        if(jobs::num_workers())
+            jobs::submit(&resume_job, request->handle.address());
+        else queue_main(request->handle);
+    }
+}
+
+void TaskPromiseBase::unhandled_exception(void)
+{
+    if(!detached) {
+        exception = std::current_exception();
+        return;
+    }
+
+    // Nobody is going to await this task
+    try {
+        throw;
+    }
+    catch(const std::exception &ex) {
+        QF_error("task: unhandled exception: %s", ex.what());
+    }
+    catch(...) {
+        QF_error("task: unhandled exception");
+    }
+}
+
+void tasks::init(void)
+{
+    main_thread = std::this_thread::get_id();
+    read_shutdown = false;
+    read_thread = std::thread(&read_main);
+}
+
+void tasks::deinit(void)
+{
+    {
+        std::lock_guard<std::mutex> lock(read_mutex);
+        read_shutdown = true;
+    }
+
+    read_cv.notify_all();
+
+    if(read_thread.joinable())
+        read_thread.join();
+
+    std::lock_guard<std::mutex> lock(main_mutex);
+
+    if(!main_queue.empty() || !counter_waits.empty())
+        QF_warning("task: %zu tasks were never resumed", main_queue.size() + counter_waits.size());
+    main_queue.clear();
+    counter_waits.clear();
+}
+
+void tasks::update_frame(void)
+{
+    QF_profile_zone("tasks::update_frame");
+
+    std::vector<std::coroutine_handle<>> resumed;
+
+    {
+        std::lock_guard<std::mutex> lock(main_mutex);
+        resumed.swap(main_queue);
+
+        for(auto it = counter_waits.begin(); it != counter_waits.end();) {
+            if(it->counter->value.load(std::memory_order_acquire)) {
+                ++it;
+                continue;
+            }
+
+            resumed.push_back(it->handle);
+            it = counter_waits.erase(it);
+        }
+    }
+
+    for(auto handle : resumed) {
+        handle.resume();
+    }
+}
+
+void tasks::spawn(Task<void> task)
+{
+    auto handle = task.release();
+
+    if(handle) {
+        handle.promise().detached = true;
+        handle.resume();
+    }
+}
+
+bool tasks::ResumeOnMain::await_ready(void) const noexcept
+{
+    return std::this_thread::get_id() == main_thread;
+}
+
+void tasks::ResumeOnMain::await_suspend(std::coroutine_handle<> handle) const
+{
+    queue_main(handle);
+}
+
+void tasks::ResumeOnMain::await_resume(void) const noexcept
+{
+
+}
+
+bool tasks::ResumeOnWorker::await_ready(void) const noexcept
+{
+    return jobs::num_workers() == 0U;
+}
+
+void tasks::ResumeOnWorker::await_suspend(std::coroutine_handle<> handle) const
+{
+    jobs::submit(&resume_job, handle.address());
+}
+
+void tasks::ResumeOnWorker::await_resume(void) const noexcept
+{
+
+}
+
+bool tasks::NextFrame::await_ready(void) const noexcept
+{
+    return false;
+}
+
+void tasks::NextFrame::await_suspend(std::coroutine_handle<> handle) const
+{
+    queue_main(handle);
+}
+
+void tasks::NextFrame::await_resume(void) const noexcept
+{
+
+}
+
+bool tasks::WaitCounter::await_ready(void) const noexcept
+{
+    return counter->value.load(std::memory_order_acquire) == 0;
+}
+
+void tasks::WaitCounter::await_suspend(std::coroutine_handle<> handle) const
+{
+    std::lock_guard<std::mutex> lock(main_mutex);
+    counter_waits.push_back(CounterWait { counter, handle });
+}
+
+void tasks::WaitCounter::await_resume(void) const noexcept
+{
+
+}
+
+bool tasks::ReadFile::await_ready(void) const noexcept
+{
+    return false;
+}
+
+void tasks::ReadFile::await_suspend(std::coroutine_handle<> awaiting)
+{
+    handle = awaiting;
+
+    {
+        std::lock_guard<std::mutex> lock(read_mutex);
+        read_queue.push_back(this);
+    }
+
+    read_cv.notify_one();
+}
+
+FileReadResult tasks::ReadFile::await_resume(void)
+{
+    return std::move(result);
+}
+
+tasks::ResumeOnMain tasks::resume_on_main(void)
+{
+    return ResumeOnMain();
+}
+
+tasks::ResumeOnWorker tasks::resume_on_worker(void)
+{
+    return ResumeOnWorker();
+}
+
+tasks::NextFrame tasks::next_frame(void)
+{
+    return NextFrame();
+}
+
+tasks::WaitCounter tasks::wait_for(const JobCounter &counter)
+{
+    return WaitCounter { &counter };
+}
+
+tasks::ReadFile tasks::read_file(std::string path)
+{
+    return ReadFile { std::move(path), FileReadResult(), nullptr };
+}
@@ -0,0 +1,327 @@
+#ifndef CORE_TASK_HH
+#define CORE_TASK_HH 1
+#pragma once
+
+#include "core/assert.hh"
+
+struct JobCounter;
+
+template<typename T>
+class Task;
+
+/**
+ * State shared by all task promises; a task
+ * resumes whoever awaited it once it finishes
+ */
+struct TaskPromiseBase {
+    struct FinalAwaiter final {
+        bool await_ready(void) const noexcept;
+        template<typename P>
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<P> handle) noexcept;
+        void await_resume(void) const noexcept;
+    };
+
+    std::coroutine_handle<> continuation;
+    std::exception_ptr exception;
+    bool detached = false;
+
+    std::suspend_always initial_suspend(void) const noexcept;
+    FinalAwaiter final_suspend(void) const noexcept;
+    void unhandled_exception(void);
+};
+
+template<typename T>
+struct TaskPromise final : public TaskPromiseBase {
+    std::optional<T> value;
+
+    Task<T> get_return_object(void);
+    void return_value(T result);
+};
+
+template<>
+struct TaskPromise<void> final : public TaskPromiseBase {
+    Task<void> get_return_object(void);
+    void return_void(void) const noexcept;
+};
+
+/**
+ * A lazily started coroutine; awaiting a task starts
+ * it and suspends the awaiting coroutine until it is
+ * done, tasks::spawn starts a task without awaiting it
+ * @note Tasks resume on whatever thread they are
+ * woken up on; use tasks::resume_on_main and
+ * tasks::resume_on_worker to move between threads
+ */
+template<typename T>
+class Task final {
+public:
+    using promise_type = TaskPromise<T>;
+    using handle_type = std::coroutine_handle<promise_type>;
+
+    struct Awaiter final {
+        handle_type handle;
+
+        bool await_ready(void) const noexcept;
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept;
+        T await_resume(void);
+    };
+
+public:
+    Task(void) = default;
+    explicit Task(handle_type handle);
+    Task(Task &&other) noexcept;
+    Task(const Task &other) = delete;
+    Task &operator=(Task &&other) noexcept;
+    Task &operator=(const Task &other) = delete;
+    ~Task(void);
+
+    Awaiter operator co_await(void) const noexcept;
+    handle_type release(void) noexcept;
+
+private:
+    handle_type handle;
+};
+
+/**
+ * Result of tasks::read_file
+ */
+struct FileReadResult final {
+    bool success;
+    std::vector<std::byte> contents;
+};
+
+namespace tasks
+{
+/**
+ * Remembers the calling thread as the main
+ * thread and starts the file reading thread
+ */
+void init(void);
+
+/**
+ * Stops the file reading thread; tasks that are
+ * still suspended at this point are never resumed
+ */
+void deinit(void);
+
+/**
+ * Resumes tasks waiting for the main thread, for the
+ * next frame or for job counters that reached zero
+ * @note Should be called once per frame from the main thread
+ */
+void update_frame(void);
+
+/**
+ * Starts a task without awaiting it; the task runs on the
+ * calling thread until it first suspends and destroys itself
+ * once it finishes. Exceptions escaping it are logged
+ * @param task The task
+ */
+void spawn(Task<void> task);
+} // namespace tasks
+
+namespace tasks
+{
+struct ResumeOnMain final {
+    bool await_ready(void) const noexcept;
+    void await_suspend(std::coroutine_handle<> handle) const;
+    void await_resume(void) const noexcept;
+};
+
+struct ResumeOnWorker final {
+    bool await_ready(void) const noexcept;
+    void await_suspend(std::coroutine_handle<> handle) const;
+    void await_resume(void) const noexcept;
+};
+
+struct NextFrame final {
+    bool await_ready(void) const noexcept;
+    void await_suspend(std::coroutine_handle<> handle) const;
+    void await_resume(void) const noexcept;
+};
+
+struct WaitCounter final {
+    const JobCounter *counter;
+
+    bool await_ready(void) const noexcept;
+    void await_suspend(std::coroutine_handle<> handle) const;
+    void await_resume(void) const noexcept;
+};
+
+struct ReadFile final {
+    std::string path;
+    FileReadResult result;
+    std::coroutine_handle<> handle;
+
+    bool await_ready(void) const noexcept;
+    void await_suspend(std::coroutine_handle<> awaiting);
+    FileReadResult await_resume(void);
+};
+} // namespace tasks
+
+namespace tasks
+{
+/**
+ * Continues on the main thread; this doesn't
+ * suspend if the task is already running there
+ */
+ResumeOnMain resume_on_main(void);
+
+/**
+ * Continues on a job system worker; this doesn't
+ * suspend if the job system has no workers
+ */
+ResumeOnWorker resume_on_worker(void);
+
+/**
+ * Continues on the main thread during the next tasks::update_frame
+ */
+NextFrame next_frame(void);
+
+/**
+ * Continues on the main thread once the counter reaches zero;
+ * the counter is polled once per frame in tasks::update_frame
+ * @param counter Counter the jobs were submitted with
+ */
+WaitCounter wait_for(const JobCounter &counter);
+
+/**
+ * Reads a whole file on the file reading thread
+ * without tying up a worker; the task continues on
+ * a worker, or on the main thread without workers
+ * @param path PhysFS path
+ */
+ReadFile read_file(std::string path);
+} // namespace tasks
+
+inline bool TaskPromiseBase::FinalAwaiter::await_ready(void) const noexcept
+{
+    return false;
+}
+
+template<typename P>
+inline std::coroutine_handle<> TaskPromiseBase::FinalAwaiter::await_suspend(std::coroutine_handle<P> handle) noexcept
+{
+    auto &promise = handle.promise();
+
+    if(promise.continuation)
+        return promise.continuation;
+    if(promise.detached)
+        handle.destroy();
+    return std::noop_coroutine();
+}
+
+inline void TaskPromiseBase::FinalAwaiter::await_resume(void) const noexcept
+{
+
+}
+
+inline std::suspend_always TaskPromiseBase::initial_suspend(void) const noexcept
+{
+    return {};
+}
+
+inline TaskPromiseBase::FinalAwaiter TaskPromiseBase::final_suspend(void) const noexcept
+{
+    return {};
+}
+
+template<typename T>
+inline Task<T> TaskPromise<T>::get_return_object(void)
+{
+    return Task<T>(std::coroutine_handle<TaskPromise<T>>::from_promise(*this));
+}
+
+template<typename T>
+inline void TaskPromise<T>::return_value(T result)
+{
+    value.emplace(std::move(result));
+}
+
+inline Task<void> TaskPromise<void>::get_return_object(void)
+{
+    return Task<void>(std::coroutine_handle<TaskPromise<void>>::from_promise(*this));
+}
+
+inline void TaskPromise<void>::return_void(void) const noexcept
+{
+
+}
+
+template<typename T>
+inline bool Task<T>::Awaiter::await_ready(void) const noexcept
+{
+    // An empty task goes straight
+    // to await_resume which throws
+    return !handle || handle.done();
+}
+
+template<typename T>
+inline std::coroutine_handle<> Task<T>::Awaiter::await_suspend(std::coroutine_handle<> awaiting) noexcept
+{
+    // Symmetric transfer into the task; it
+    // transfers back into us when it finishes
+    handle.promise().continuation = awaiting;
+    return handle;
+}
+
+template<typename T>
+inline T Task<T>::Awaiter::await_resume(void)
+{
+    QF_assert_msg(handle, "awaiting an empty task");
+
+    auto &promise = handle.promise();
+
+    if(promise.exception)
+        std::rethrow_exception(promise.exception);
+
+    if constexpr(!std::is_void_v<T>) {
+        return std::move(*promise.value);
+    }
+}
+
+template<typename T>
+inline Task<T>::Task(handle_type handle) : handle(handle)
+{
+
+}
+
+template<typename T>
+inline Task<T>::Task(Task &&other) noexcept : handle(std::exchange(other.handle, nullptr))
+{
+
+}
+
+template<typename T>
+inline Task<T> &Task<T>::operator=(Task &&other) noexcept
+{
+    if(this != &other) {
+        if(handle)
+            handle.destroy();
+        handle = std::exchange(other.handle, nullptr);
+    }
+
+    return *this;
+}
+
+template<typename T>
+inline Task<T>::~Task(void)
+{
+    if(handle) {
+        handle.destroy();
+    }
+}
+
+template<typename T>
+inline typename Task<T>::Awaiter Task<T>::operator co_await(void) const noexcept
+{
+    return Awaiter { handle };
+}
+
+template<typename T>
+inline typename Task<T>::handle_type Task<T>::release(void) noexcept
+{
+    return std::exchange(handle, nullptr);
+}
+
+#endif /* CORE_TASK_HH */
@@ -0,0 +1,121 @@
+#ifndef CORE_VARINT_HH
+#define CORE_VARINT_HH 1
+#pragma once
+
+#include "core/byteorder.hh"
+
+#if defined(_MSC_VER) && !defined(__clang__)
+#include <intrin.h>
+#endif
+
+/**
+ * Maximum size of an encoded 64-bit varint
+ */
+constexpr static std::size_t VARINT_MAX_SIZE = 10;
+
+namespace varint
+{
+/**
+ * Encodes a value as an LEB128 unsigned varint
+ * @param value The value
+ * @param data Destination memory, at least VARINT_MAX_SIZE bytes
+ * @returns Amount of bytes written
+ * @see Wikipedia page for [LEB128](https://en.wikipedia.org/wiki/LEB128)
+ */
+static inline std::size_t encode(std::uint64_t value, std::byte *data);
+
+/**
+ * Decodes an LEB128 unsigned varint
+ * @param data Source memory
+ * @param size Amount of bytes available
+ * @param value Decoded value
+ * @returns Amount of bytes consumed or zero if the
+ * varint is truncated or longer than VARINT_MAX_SIZE
+ */
+static inline std::size_t decode(const std::byte *data, std::size_t size, std::uint64_t &value);
+
+/**
+ * Maps signed values to unsigned ones so that
+ * small negative values stay small: 0, -1, 1, -2, 2...
+ * @param value Signed value
+ * @returns Zigzag-encoded value
+ */
+static inline std::uint64_t zigzag(std::int64_t value);
+
+/**
+ * Reverses varint::zigzag
+ * @param value Zigzag-encoded value
+ * @returns Signed value
+ */
+static inline std::int64_t unzigzag(std::uint64_t value);
+} // namespace varint
+
+static inline std::size_t varint::encode(std::uint64_t value, std::byte *data)
+{
+    std::size_t size = 0;
+
+    while(value >= UINT64_C(0x80)) {
+        data[size++] = static_cast<std::byte>((value & UINT64_C(0x7F)) | UINT64_C(0x80));
+        value >>= 7U;
+    }
+
+    data[size++] = static_cast<std::byte>(value);
+    return size;
+}
+
+static inline std::size_t varint::decode(const std::byte *data, std::size_t size, std::uint64_t &value)
+{
+    if(size >= sizeof(std::uint64_t)) {
+        // Fast path: the terminating byte is the first one with
+        // its high bit clear; find it within a single 64-bit window
+        // and squeeze the 7-bit groups together without looping
+        const std::uint64_t word = byteorder::load_little64(data);
+        const std::uint64_t stops = ~word & UINT64_C(0x8080808080808080);
+
+        if(stops) {
+#if defined(_MSC_VER) && !defined(__clang__)
+            unsigned long index;
+            _BitScanForward64(&index, stops);
+            const std::size_t length = (static_cast<std::size_t>(index) + 1U) / 8U;
+#else
+            const std::size_t length = (static_cast<std::size_t>(__builtin_ctzll(stops)) + 1U) / 8U;
+#endif
+
+            std::uint64_t x = word & (~UINT64_C(0) >> (64U - 8U * length)) & UINT64_C(0x7F7F7F7F7F7F7F7F);
+            x = (x & UINT64_C(0x007F007F007F007F)) | ((x & UINT64_C(0x7F007F007F007F00)) >> 1U);
+            x = (x & UINT64_C(0x00003FFF00003FFF)) | ((x & UINT64_C(0x3FFF00003FFF0000)) >> 2U);
+            x = (x & UINT64_C(0x000000000FFFFFFF)) | ((x & UINT64_C(0x0FFFFFFF00000000)) >> 4U);
+
+            value = x;
+            return length;
+        }
+    }
+
+    std::uint64_t result = UINT64_C(0);
+    const std::size_t limit = std::min(size, VARINT_MAX_SIZE);
+
+    for(std::size_t i = 0; i < limit; ++i) {
+        const auto byte = static_cast<std::uint64_t>(data[i]);
+        result |= (byte & UINT64_C(0x7F)) << (7U * i);
+
+        if(!(byte & UINT64_C(0x80))) {
+            value = result;
+            return i + 1U;
+        }
+    }
+
+    value = UINT64_C(0);
+    return 0;
+}
+
+static inline std::uint64_t varint::zigzag(std::int64_t value)
+{
+    return (static_cast<std::uint64_t>(value) << 1U) ^ static_cast<std::uint64_t>(value >> 63);
+}
+
+static inline std::int64_t varint::unzigzag(std::uint64_t value)
+{
+    return static_cast<std::int64_t>(value >> 1U) ^ -static_cast<std::int64_t>(value & UINT64_C(1));
+}
+
+#endif /* CORE_VARINT_HH */
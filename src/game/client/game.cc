@@ -1,9 +1,17 @@
 #include "client/precompiled.hh"
 #include "client/game.hh"
 
+#include "core/profiler.hh"
+
+#include "shared/systems.hh"
+
+#include "client/memory_view.hh"
+#include "client/profiler_view.hh"
+
 void client_game::init(void)
 {
-
+    memory_view::init();
+    profiler_view::init();
 }
 
 void client_game::init_late(void)
@@ -13,12 +21,14 @@ void client_game::init_late(void)
 
 void client_game::deinit(void)
 {
-
+    systems::deinit();
 }
 
 void client_game::fixed_update(void)
 {
+    QF_profile_zone("client_game::fixed_update");
 
+    systems::run();
 }
 
 void client_game::fixed_update_late(void)
@@ -28,15 +38,20 @@ void client_game::fixed_update_late(void)
 
 void client_game::window_update(void)
 {
-
+    QF_profile_zone("client_game::window_update");
 }
 
 void client_game::window_update_late(void)
 {
-
+    QF_profile_zone("client_game::window_update_late");
 }
 
 void client_game::layout_imgui(void)
 {
+    QF_profile_zone("client_game::layout_imgui");
+
     ImGui::ShowDemoWindow();
+
+    memory_view::layout();
+    profiler_view::layout();
 }
@@ -10,3 +10,4 @@ float globals::window_frametime;
 float globals::window_frametime_avg;
 std::uint64_t globals::window_frametime_us;
 std::size_t globals::window_framecount;
+std::int64_t globals::window_pacing_error_us;
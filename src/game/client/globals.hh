@@ -18,6 +18,7 @@ extern float window_frametime;
 extern float window_frametime_avg;
 extern std::uint64_t window_frametime_us;
 extern std::size_t window_framecount;
+extern std::int64_t window_pacing_error_us;
 } // namespace globals
 
 #endif /* CLIENT_GLOBALS_HH */
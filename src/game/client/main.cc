@@ -1,14 +1,22 @@
 #include "client/precompiled.hh"
 
+#include "core/arena.hh"
 #include "core/assert.hh"
 #include "core/cmdline.hh"
 #include "core/config.hh"
 #include "core/constexpr.hh"
 #include "core/crc64.hh"
 #include "core/epoch.hh"
+#include "core/framelimiter.hh"
+#include "core/jobs.hh"
 #include "core/logging.hh"
+#include "core/memtrack.hh"
+#include "core/profiler.hh"
+#include "core/rwpool.hh"
+#include "core/task.hh"
 
 #include "shared/content.hh"
+#include "shared/events.hh"
 #include "shared/game.hh"
 
 #include "client/display.hh"
@@ -17,6 +25,141 @@
 #include "client/input.hh"
 #include "client/render_api.hh"
 
+// Frame rate limit; zero makes the client
+// follow the display's refresh rate and negative
+// values disable limiting altogether
+static ConfigHandle<float> fps_max;
+
+static FrameLimiter frame_limiter;
+static std::uint32_t frame_limiter_generation;
+
+// Simulation tick rate, clamped to [1, 1000], and the most
+// ticks a single frame may run to catch up after a stall
+static ConfigHandle<float> tick_rate;
+static ConfigHandle<unsigned int> max_catchup_ticks;
+
+static std::uint64_t fixed_accumulator_us;
+static std::uint32_t tick_rate_generation;
+
+static void update_frame_limiter(void)
+{
+    auto rate = config::get(fps_max);
+
+    if(rate == 0.0f) {
+        if(auto mode = display::current_mode())
+            rate = mode->refresh_rate;
+        else rate = -1.0f;
+    }
+
+    FrameLimiter::set_rate(frame_limiter, rate);
+    frame_limiter_generation = config::generation(fps_max);
+
+    QF_verbose("client: frame limiter: %.03f FPS", cxpr::max(rate, 0.0f));
+}
+
+static void update_tick_rate(void)
+{
+    auto rate = config::get(tick_rate);
+
+    // Written so that NaN ends up at the lower bound too
+    if(!(rate >= 1.0f))
+        rate = 1.0f;
+    rate = cxpr::min(rate, 1000.0f);
+
+    globals::fixed_frametime_us = static_cast<std::uint64_t>(std::round(1000000.0 / static_cast<double>(rate)));
+    globals::fixed_frametime = static_cast<float>(globals::fixed_frametime_us) / 1000000.0f;
+    globals::fixed_frametime_avg = globals::fixed_frametime;
+    tick_rate_generation = config::generation(tick_rate);
+
+    QF_verbose("client: tick rate: %.03f TPS", rate);
+}
+
+static void run_fixed_ticks(void)
+{
+    if(config::generation(tick_rate) != tick_rate_generation)
+        update_tick_rate();
+
+    fixed_accumulator_us += globals::window_frametime_us;
+
+    const unsigned int max_ticks = cxpr::max(config::get(max_catchup_ticks), 1U);
+    unsigned int num_ticks = 0U;
+
+    while((fixed_accumulator_us >= globals::fixed_frametime_us) && (num_ticks < max_ticks)) {
+        client_game::fixed_update();
+        client_game::fixed_update_late();
+
+        fixed_accumulator_us -= globals::fixed_frametime_us;
+        globals::fixed_framecount += 1;
+        num_ticks += 1U;
+    }
+
+    // Simulation can't keep up; drop the backlog
+    // instead of spiralling into ever longer frames
+    if(fixed_accumulator_us >= globals::fixed_frametime_us) {
+        fixed_accumulator_us %= globals::fixed_frametime_us;
+    }
+
+    globals::fixed_alpha = static_cast<float>(fixed_accumulator_us) / static_cast<float>(globals::fixed_frametime_us);
+
+    QF_profile_counter("fixed_ticks", num_ticks);
+}
+
+// High-rate mice report motion and wheel events
+// far more often than the game can make use of, so
+// all of a frame's events are merged into one
+static SDL_MouseMotionEvent pending_motion;
+static SDL_MouseWheelEvent pending_wheel;
+static bool has_pending_motion = false;
+static bool has_pending_wheel = false;
+
+static void flush_pending_motion(void)
+{
+    if(has_pending_motion) {
+        globals::dispatcher.enqueue(pending_motion);
+        has_pending_motion = false;
+    }
+}
+
+static void flush_pending_wheel(void)
+{
+    if(has_pending_wheel) {
+        globals::dispatcher.enqueue(pending_wheel);
+        has_pending_wheel = false;
+    }
+}
+
+static void coalesce_motion(const SDL_MouseMotionEvent &event)
+{
+    if(has_pending_motion && (pending_motion.windowID == event.windowID) && (pending_motion.which == event.which)) {
+        const float xrel = pending_motion.xrel + event.xrel;
+        const float yrel = pending_motion.yrel + event.yrel;
+        pending_motion = event;
+        pending_motion.xrel = xrel;
+        pending_motion.yrel = yrel;
+        return;
+    }
+
+    flush_pending_motion();
+    pending_motion = event;
+    has_pending_motion = true;
+}
+
+static void coalesce_wheel(const SDL_MouseWheelEvent &event)
+{
+    if(has_pending_wheel && (pending_wheel.windowID == event.windowID) && (pending_wheel.which == event.which) && (pending_wheel.direction == event.direction)) {
+        const float x = pending_wheel.x + event.x;
+        const float y = pending_wheel.y + event.y;
+        pending_wheel = event;
+        pending_wheel.x = x;
+        pending_wheel.y = y;
+        return;
+    }
+
+    flush_pending_wheel();
+    pending_wheel = event;
+    has_pending_wheel = true;
+}
+
 static bool poll_events(void)
 {
     SDL_Event event;
@@ -37,28 +180,32 @@ static bool poll_events(void)
             QF_throw("client: SDLK_ESCAPE throw hack");
         }
 
+        // Listeners run later in events::update
         switch(event.type) {
         case SDL_EVENT_KEY_DOWN:
-            globals::dispatcher.trigger(event.key);
+            globals::dispatcher.enqueue(event.key);
             break;
         case SDL_EVENT_KEY_UP:
-            globals::dispatcher.trigger(event.key);
+            globals::dispatcher.enqueue(event.key);
             break;
         case SDL_EVENT_MOUSE_MOTION:
-            globals::dispatcher.trigger(event.motion);
+            coalesce_motion(event.motion);
             break;
         case SDL_EVENT_MOUSE_BUTTON_DOWN:
-            globals::dispatcher.trigger(event.button);
+            globals::dispatcher.enqueue(event.button);
             break;
         case SDL_EVENT_MOUSE_BUTTON_UP:
-            globals::dispatcher.trigger(event.button);
+            globals::dispatcher.enqueue(event.button);
             break;
         case SDL_EVENT_MOUSE_WHEEL:
-            globals::dispatcher.trigger(event.wheel);
+            coalesce_wheel(event.wheel);
             break;
         }
     }
 
+    flush_pending_motion();
+    flush_pending_wheel();
+
     return true;
 }
 
@@ -66,10 +213,30 @@ static void wrapped_main(int argc, char **argv)
 {
     cmdline::init(argc, argv);
 
+    // PhysFS allocator has to be set
+    // before content::init is called
+    memtrack::init();
+
     logging::init_from_cmdline();
 
+    logging::init();
+
     content::init(argv[0]);
 
+    rwpool::init();
+
+    profiler::init();
+
+    frame_arena::init();
+
+    jobs::init();
+
+    fps_max = config::add<float>("client.fps_max", 0.0f);
+    tick_rate = config::add<float>("client.tick_rate", 60.0f);
+    max_catchup_ticks = config::add<unsigned int>("client.max_catchup_ticks", 5U);
+
+    events::init();
+
     shared_game::init();
 
     display::init();
@@ -93,17 +260,24 @@ static void wrapped_main(int argc, char **argv)
         config::load("config/user.conf");
     }
 
-    globals::fixed_frametime = FLT_MAX;
-    globals::fixed_frametime_avg = FLT_MAX;
-    globals::fixed_frametime_us = UINT64_MAX;
+    config::watch();
+
     globals::fixed_framecount = 0;
+    globals::fixed_alpha = 0.0f;
 
     globals::window_frametime = 0.0f;
     globals::window_frametime_avg = 0.0f;
     globals::window_frametime_us = UINT64_C(0);
     globals::window_framecount = 0;
+    globals::window_pacing_error_us = INT64_C(0);
 
-    globals::curtime = epoch::microseconds();
+    globals::curtime = epoch::monotonic_us();
+
+    rwpool::init_late();
+
+    jobs::init_late();
+
+    tasks::init();
 
     display::init_late();
 
@@ -111,11 +285,20 @@ static void wrapped_main(int argc, char **argv)
 
     client_game::init_late();
 
+    FrameLimiter::setup(frame_limiter);
+    update_frame_limiter();
+
+    fixed_accumulator_us = UINT64_C(0);
+    update_tick_rate();
+
     std::uint64_t last_curtime = globals::curtime;
 
+    profiler::set_thread_name("main");
+
     while(poll_events()) {
-        globals::curtime = epoch::microseconds();
+        globals::curtime = epoch::monotonic_us();
         globals::window_frametime_us = globals::curtime - last_curtime;
+        last_curtime = globals::curtime;
         globals::window_frametime = static_cast<float>(globals::window_frametime_us) / 1000000.0f;
 
         globals::window_frametime_avg += globals::window_frametime;
@@ -127,6 +310,12 @@ static void wrapped_main(int argc, char **argv)
         auto size_min = cxpr::min<float>(globals::window_width, globals::window_height);
         globals::window_aspect = size_max / size_min;
 
+        // Input listeners have to see this frame's
+        // events before the simulation ticks
+        events::update();
+
+        run_fixed_ticks();
+
         client_game::window_update();
 
         render_api::imgui_begin_frame();
@@ -140,13 +329,53 @@ static void wrapped_main(int argc, char **argv)
         render_api::video_present();
 
         client_game::window_update_late();
+
+        config::update();
+
+        tasks::update_frame();
+
+        rwpool::update_frame();
+
+        memtrack::update_frame();
+
+        if(config::generation(fps_max) != frame_limiter_generation)
+            update_frame_limiter();
+
+        FrameLimiter::wait(frame_limiter);
+
+        profiler::end_frame();
+
+        frame_arena::next_frame();
+
+        globals::window_pacing_error_us = frame_limiter.error_ns / INT64_C(1000);
+
+        QF_profile_counter("window_frametime_us", globals::window_frametime_us);
+        QF_profile_counter("window_pacing_error_us", globals::window_pacing_error_us);
+        QF_profile_counter("memtrack.frame_allocations", memtrack::frame_allocations());
+        QF_profile_counter("frame_arena.used_bytes", frame_arena::get_stats().used_bytes);
     }
 
+    tasks::deinit();
+
+    jobs::deinit();
+
     client_game::deinit();
 
+    events::deinit();
+
     render_api::deinit();
 
+    config::unwatch();
+
     config::save("config/config.conf");
+
+    rwpool::deinit();
+
+    profiler::deinit();
+
+    memtrack::report_leaks();
+
+    logging::deinit();
 }
 
 int main(int argc, char **argv)
@@ -0,0 +1,83 @@
+#include "client/precompiled.hh"
+#include "client/memory_view.hh"
+
+#include "core/arena.hh"
+#include "core/config.hh"
+#include "core/memtrack.hh"
+
+#include "client/globals.hh"
+
+static unsigned int key_memory = SDLK_F5;
+static bool show_window = false;
+
+static void on_keyboard_event(const SDL_KeyboardEvent &event)
+{
+    if(event.down && !event.repeat && (event.key == key_memory)) {
+        show_window = !show_window;
+    }
+}
+
+void memory_view::init(void)
+{
+    config::add("key.memory", key_memory);
+
+    globals::dispatcher.sink<SDL_KeyboardEvent>().connect<&on_keyboard_event>();
+}
+
+void memory_view::layout(void)
+{
+    if(!show_window)
+        return;
+
+    ImGui::SetNextWindowSize(ImVec2(480.0f, 260.0f), ImGuiCond_FirstUseEver);
+
+    if(!ImGui::Begin("Memory", &show_window)) {
+        ImGui::End();
+        return;
+    }
+
+    const auto arena = frame_arena::get_stats();
+    ImGui::Text("Frame arena: %zu / %zu B used, %zu B high water", arena.used_bytes, arena.capacity, arena.high_water);
+
+    if(arena.overflow_bytes) {
+        ImGui::Text("Frame arena: %zu B spilled into the heap", arena.overflow_bytes);
+    }
+
+    ImGui::Separator();
+
+#if ENABLE_MEMTRACK
+    ImGui::Text("%zu allocations during the last frame", memtrack::frame_allocations());
+
+    if(ImGui::BeginTable("##tags", 5, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV)) {
+        ImGui::TableSetupColumn("Tag");
+        ImGui::TableSetupColumn("Live, KiB");
+        ImGui::TableSetupColumn("Peak, KiB");
+        ImGui::TableSetupColumn("Allocations");
+        ImGui::TableSetupColumn("Per frame");
+        ImGui::TableHeadersRow();
+
+        for(unsigned int i = 0; i < MEMTAG_COUNT; ++i) {
+            const auto tag = static_cast<QF_MemoryTag>(i);
+            const auto stats = memtrack::get_stats(tag);
+
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(memtrack::get_tag_name(tag));
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", static_cast<double>(stats.num_bytes) / 1024.0);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.1f", static_cast<double>(stats.peak_bytes) / 1024.0);
+            ImGui::TableNextColumn();
+            ImGui::Text("%zu", stats.num_allocations);
+            ImGui::TableNextColumn();
+            ImGui::Text("%zu (%zu B)", stats.frame_allocations, stats.frame_bytes);
+        }
+
+        ImGui::EndTable();
+    }
+#else
+    ImGui::TextUnformatted("Memory tracking is disabled at build time (ENABLE_MEMTRACK)");
+#endif /* ENABLE_MEMTRACK */
+
+    ImGui::End();
+}
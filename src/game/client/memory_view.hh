@@ -0,0 +1,11 @@
+#ifndef CLIENT_MEMORY_VIEW_HH
+#define CLIENT_MEMORY_VIEW_HH 1
+#pragma once
+
+namespace memory_view
+{
+void init(void);
+void layout(void);
+} // namespace memory_view
+
+#endif /* CLIENT_MEMORY_VIEW_HH */
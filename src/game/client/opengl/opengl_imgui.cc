@@ -1,8 +1,12 @@
 #include "client/precompiled.hh"
 #include "client/opengl/opengl.hh"
 
+#include "core/profiler.hh"
+
 void opengl::imgui_begin_frame(void)
 {
+    QF_profile_zone("opengl::imgui_begin_frame");
+
     ImGui_ImplOpenGL3_NewFrame();
     ImGui_ImplSDL3_NewFrame();
     ImGui::NewFrame();
@@ -10,6 +14,8 @@ void opengl::imgui_begin_frame(void)
 
 void opengl::imgui_end_frame(void)
 {
+    QF_profile_zone("opengl::imgui_end_frame");
+
     ImGui::Render();
     ImGui_ImplOpenGL3_RenderDrawData(ImGui::GetDrawData());
 }
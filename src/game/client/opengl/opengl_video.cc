@@ -4,6 +4,8 @@
 #include "core/assert.hh"
 #include "core/cmdline.hh"
 #include "core/logging.hh"
+#include "core/memtrack.hh"
+#include "core/profiler.hh"
 
 #include "shared/game.hh"
 
@@ -11,6 +13,18 @@
 
 static SDL_GLContext gl_context;
 
+#if ENABLE_MEMTRACK
+static void *imgui_allocate(std::size_t size, void *)
+{
+    return memtrack::allocate(size, alignof(std::max_align_t), MEMTAG_IMGUI);
+}
+
+static void imgui_deallocate(void *pointer, void *)
+{
+    memtrack::deallocate(pointer);
+}
+#endif /* ENABLE_MEMTRACK */
+
 static void GLAD_API_PTR on_opengl_message(GLenum source, GLenum type, GLuint id, GLenum severity, GLsizei length, const GLchar *message, const void *param)
 {
     QF_inform("opengl: %s", message);
@@ -18,6 +32,8 @@ static void GLAD_API_PTR on_opengl_message(GLenum source, GLenum type, GLuint id
 
 void opengl::video_init(void)
 {
+    QF_memory_tag(MEMTAG_RENDER);
+
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MAJOR_VERSION, 3);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_MINOR_VERSION, 3);
     SDL_GL_SetAttribute(SDL_GL_CONTEXT_PROFILE_MASK, SDL_GL_CONTEXT_PROFILE_CORE);
@@ -64,6 +80,11 @@ void opengl::video_init(void)
     QF_inform("opengl: GL_RENDERER: %s", glGetString(GL_RENDERER));
 
     IMGUI_CHECKVERSION();
+
+#if ENABLE_MEMTRACK
+    ImGui::SetAllocatorFunctions(&imgui_allocate, &imgui_deallocate);
+#endif /* ENABLE_MEMTRACK */
+
     ImGui::CreateContext();
     ImGui::StyleColorsDark();
 
@@ -90,11 +111,15 @@ void opengl::video_deinit(void)
 
 void opengl::video_prepare(void)
 {
+    QF_profile_zone("opengl::video_prepare");
+
     glClearColor(0.0f, 0.0f, 0.1f, 1.0f);
     glClear(GL_COLOR_BUFFER_BIT);
 }
 
 void opengl::video_present(void)
 {
+    QF_profile_zone("opengl::video_present");
+
     SDL_GL_SwapWindow(globals::window);
 }
@@ -0,0 +1,214 @@
+#include "client/precompiled.hh"
+#include "client/profiler_view.hh"
+
+#include "core/arena.hh"
+#include "core/config.hh"
+#include "core/constexpr.hh"
+#include "core/profiler.hh"
+
+#include "client/globals.hh"
+
+static unsigned int key_profiler = SDLK_F3;
+static bool show_window = false;
+
+#if ENABLE_PROFILER
+constexpr static float ZONE_HEIGHT = 18.0f;
+
+static unsigned int key_profiler_capture = SDLK_F4;
+static unsigned int capture_length = 300;
+
+// Accumulated over the last frame for the summary table
+struct ZoneSummary final {
+    const char *name;
+    std::size_t count;
+    std::uint64_t total_ns;
+};
+
+static ImU32 get_zone_color(const char *name)
+{
+    // FNV-1a; zone names may be the same string
+    // literal duplicated across translation units
+    std::uint32_t hash = UINT32_C(0x811C9DC5);
+
+    for(const char *c = name; *c; ++c) {
+        hash ^= static_cast<std::uint8_t>(*c);
+        hash *= UINT32_C(0x01000193);
+    }
+
+    const float hue = static_cast<float>(hash & 0xFFFF) / 65535.0f;
+    const ImColor color = ImColor::HSV(hue, 0.55f, 0.75f);
+    return static_cast<ImU32>(color);
+}
+#endif /* ENABLE_PROFILER */
+
+static void on_keyboard_event(const SDL_KeyboardEvent &event)
+{
+    if(event.down && !event.repeat && (event.key == key_profiler)) {
+        show_window = !show_window;
+        return;
+    }
+
+#if ENABLE_PROFILER
+    if(event.down && !event.repeat && (event.key == key_profiler_capture)) {
+        profiler::start_capture(capture_length);
+        return;
+    }
+#endif /* ENABLE_PROFILER */
+}
+
+#if ENABLE_PROFILER
+static void layout_timeline(const ProfilerFrame &frame)
+{
+    const std::uint64_t duration = cxpr::max<std::uint64_t>(1, frame.end_ns - frame.start_ns);
+    const float width = cxpr::max(ImGui::GetContentRegionAvail().x, 64.0f);
+
+    auto draw_list = ImGui::GetWindowDrawList();
+
+    for(std::uint32_t thread = 0; thread < profiler::num_threads(); ++thread) {
+        std::uint32_t num_rows = 0;
+
+        for(const auto &event : frame.events) {
+            if(event.thread == thread) {
+                num_rows = cxpr::max(num_rows, event.depth + 1);
+            }
+        }
+
+        if(num_rows == 0) {
+            // The thread didn't do
+            // anything during this frame
+            continue;
+        }
+
+        ImGui::TextUnformatted(profiler::get_thread_name(thread).c_str());
+
+        const ImVec2 origin = ImGui::GetCursorScreenPos();
+
+        for(const auto &event : frame.events) {
+            if(event.thread != thread)
+                continue;
+
+            const std::uint64_t start = cxpr::max(event.start_ns, frame.start_ns) - frame.start_ns;
+            const std::uint64_t end = cxpr::min(event.end_ns, frame.end_ns) - frame.start_ns;
+
+            const float x0 = origin.x + width * static_cast<float>(start) / static_cast<float>(duration);
+            const float x1 = origin.x + width * static_cast<float>(end) / static_cast<float>(duration);
+            const float y0 = origin.y + ZONE_HEIGHT * static_cast<float>(event.depth);
+            const float y1 = y0 + ZONE_HEIGHT - 1.0f;
+
+            const ImVec2 rect_min = ImVec2(x0, y0);
+            const ImVec2 rect_max = ImVec2(cxpr::max(x1, x0 + 1.0f), y1);
+
+            draw_list->AddRectFilled(rect_min, rect_max, get_zone_color(event.name));
+
+            if(rect_max.x - rect_min.x > 24.0f) {
+                const ImVec4 clip_rect = ImVec4(rect_min.x, rect_min.y, rect_max.x - 2.0f, rect_max.y);
+                const ImVec2 text_pos = ImVec2(rect_min.x + 2.0f, rect_min.y + 1.0f);
+                draw_list->AddText(nullptr, 0.0f, text_pos, IM_COL32_WHITE, event.name, nullptr, 0.0f, &clip_rect);
+            }
+
+            if(ImGui::IsMouseHoveringRect(rect_min, rect_max)) {
+                ImGui::SetTooltip("%s: %.3f ms", event.name, static_cast<double>(event.end_ns - event.start_ns) / 1.0e6);
+            }
+        }
+
+        ImGui::Dummy(ImVec2(width, ZONE_HEIGHT * static_cast<float>(num_rows)));
+    }
+}
+
+static void layout_summary(const ProfilerFrame &frame)
+{
+    FrameVector<ZoneSummary> summary;
+
+    for(const auto &event : frame.events) {
+        auto it = std::find_if(summary.begin(), summary.end(), [&event](const ZoneSummary &zone) {
+            return !std::strcmp(zone.name, event.name);
+        });
+
+        if(it == summary.end()) {
+            summary.push_back(ZoneSummary{event.name, 0, 0});
+            it = summary.end() - 1;
+        }
+
+        it->count += 1;
+        it->total_ns += event.end_ns - event.start_ns;
+    }
+
+    std::sort(summary.begin(), summary.end(), [](const ZoneSummary &a, const ZoneSummary &b) {
+        return a.total_ns > b.total_ns;
+    });
+
+    if(ImGui::BeginTable("##zones", 3, ImGuiTableFlags_RowBg | ImGuiTableFlags_BordersInnerV)) {
+        ImGui::TableSetupColumn("Zone");
+        ImGui::TableSetupColumn("Calls");
+        ImGui::TableSetupColumn("Total, ms");
+        ImGui::TableHeadersRow();
+
+        for(const auto &zone : summary) {
+            ImGui::TableNextRow();
+            ImGui::TableNextColumn();
+            ImGui::TextUnformatted(zone.name);
+            ImGui::TableNextColumn();
+            ImGui::Text("%zu", zone.count);
+            ImGui::TableNextColumn();
+            ImGui::Text("%.3f", static_cast<double>(zone.total_ns) / 1.0e6);
+        }
+
+        ImGui::EndTable();
+    }
+}
+#endif /* ENABLE_PROFILER */
+
+void profiler_view::init(void)
+{
+    config::add("key.profiler", key_profiler);
+
+#if ENABLE_PROFILER
+    config::add("key.profiler_capture", key_profiler_capture);
+    config::add("profiler.capture_length", capture_length);
+#endif /* ENABLE_PROFILER */
+
+    globals::dispatcher.sink<SDL_KeyboardEvent>().connect<&on_keyboard_event>();
+}
+
+void profiler_view::layout(void)
+{
+    if(!show_window)
+        return;
+
+    ImGui::SetNextWindowSize(ImVec2(640.0f, 320.0f), ImGuiCond_FirstUseEver);
+
+    if(!ImGui::Begin("Profiler", &show_window)) {
+        ImGui::End();
+        return;
+    }
+
+#if ENABLE_PROFILER
+    bool enabled = profiler::is_enabled();
+
+    if(ImGui::Checkbox("Record", &enabled))
+        profiler::set_enabled(enabled);
+
+    const auto &frame = profiler::last_frame();
+
+    ImGui::SameLine();
+
+    if(profiler::is_capturing())
+        ImGui::TextUnformatted("Capturing...");
+    else if(ImGui::Button("Capture"))
+        profiler::start_capture(capture_length);
+
+    ImGui::SameLine();
+    ImGui::Text("frame %" PRIu64 ": %.3f ms, %zu zones, %zu dropped", frame.number,
+        static_cast<double>(frame.end_ns - frame.start_ns) / 1.0e6, frame.events.size(), profiler::num_dropped());
+
+    layout_timeline(frame);
+
+    ImGui::Separator();
+
+    layout_summary(frame);
+#else
+    ImGui::TextUnformatted("The profiler is disabled at build time (ENABLE_PROFILER)");
+#endif /* ENABLE_PROFILER */
+
+    ImGui::End();
+}
@@ -0,0 +1,11 @@
+#ifndef CLIENT_PROFILER_VIEW_HH
+#define CLIENT_PROFILER_VIEW_HH 1
+#pragma once
+
+namespace profiler_view
+{
+void init(void);
+void layout(void);
+} // namespace profiler_view
+
+#endif /* CLIENT_PROFILER_VIEW_HH */
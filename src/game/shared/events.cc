@@ -0,0 +1,71 @@
+#include "shared/precompiled.hh"
+#include "shared/events.hh"
+
+#include "core/profiler.hh"
+
+#include "shared/globals.hh"
+
+thread_local static bool main_thread = false;
+
+static std::mutex queues_mutex;
+static std::vector<EventQueue *> queues;
+
+void events::init(void)
+{
+    main_thread = true;
+}
+
+void events::deinit(void)
+{
+    std::lock_guard<std::mutex> lock(queues_mutex);
+
+    for(auto it = queues.begin(); it != queues.end();) {
+        if((*it)->detached) {
+            delete *it;
+            it = queues.erase(it);
+            continue;
+        }
+
+        ++it;
+    }
+}
+
+void events::update(void)
+{
+    QF_profile_zone("events::update");
+
+    {
+        std::lock_guard<std::mutex> lock(queues_mutex);
+
+        for(auto it = queues.begin(); it != queues.end();) {
+            (*it)->merge(globals::dispatcher);
+
+            if((*it)->detached) {
+                delete *it;
+                it = queues.erase(it);
+                continue;
+            }
+
+            ++it;
+        }
+    }
+
+    globals::dispatcher.update();
+}
+
+bool events::is_main_thread(void)
+{
+    return main_thread;
+}
+
+void events::attach(EventQueue *queue)
+{
+    std::lock_guard<std::mutex> lock(queues_mutex);
+    queues.push_back(queue);
+}
+
+void events::detach(EventQueue *queue)
+{
+    std::lock_guard<std::mutex> lock(queues_mutex);
+    queue->detached = true;
+}
@@ -0,0 +1,154 @@
+#ifndef SHARED_EVENTS_HH
+#define SHARED_EVENTS_HH 1
+#pragma once
+
+#include "shared/globals.hh"
+
+/**
+ * Events queued by a single thread other than
+ * the main one; merged into globals::dispatcher
+ * by events::update
+ */
+class EventQueue {
+public:
+    virtual ~EventQueue(void) = default;
+    virtual void merge(QF_Dispatcher &dispatcher) = 0;
+
+public:
+    bool detached = false;
+};
+
+template<typename T>
+class ThreadEventQueue final : public EventQueue {
+public:
+    void push(const T &event);
+    void merge(QF_Dispatcher &dispatcher) override;
+
+private:
+    // The owning thread pushes into the active buffer
+    // while the main thread drains the other one; the
+    // busy flag tells the main thread when a push that
+    // started before a buffer swap is still running
+    std::vector<T> buffers[2];
+    std::atomic<unsigned int> active = 0U;
+    std::atomic<bool> busy = false;
+};
+
+namespace events
+{
+/**
+ * Remembers the calling thread as the main thread
+ */
+void init(void);
+
+/**
+ * Frees queues left behind by threads that have exited
+ */
+void deinit(void);
+
+/**
+ * Merges queued events from every thread into
+ * globals::dispatcher and delivers all of them
+ * @note Should be called once per frame from the main thread
+ */
+void update(void);
+} // namespace events
+
+namespace events
+{
+/**
+ * Queues an event for the next events::update; the main thread
+ * queues directly into globals::dispatcher, other threads queue
+ * into a thread-local buffer without taking any locks
+ * @param event The event
+ */
+template<typename T>
+void enqueue(const T &event);
+
+/**
+ * Check if the calling thread is the main thread
+ * @returns true if it called events::init
+ */
+bool is_main_thread(void);
+
+/**
+ * Hands a thread's queue over to events::update
+ * @param queue A newly created queue
+ */
+void attach(EventQueue *queue);
+
+/**
+ * Marks a queue as abandoned by its thread; it
+ * is merged once more and then freed
+ * @param queue A queue passed to events::attach
+ */
+void detach(EventQueue *queue);
+} // namespace events
+
+template<typename T>
+struct ThreadEventHandle final {
+    ThreadEventQueue<T> *queue = nullptr;
+    ~ThreadEventHandle(void);
+};
+
+// A function-local thread_local instead of a variable
+// template; some compilers never destroy the latter
+template<typename T>
+static inline ThreadEventHandle<T> &get_thread_event_handle(void)
+{
+    thread_local ThreadEventHandle<T> handle;
+    return handle;
+}
+
+template<typename T>
+inline void ThreadEventQueue<T>::push(const T &event)
+{
+    busy.store(true, std::memory_order_seq_cst);
+    buffers[active.load(std::memory_order_seq_cst)].push_back(event);
+    busy.store(false, std::memory_order_release);
+}
+
+template<typename T>
+inline void ThreadEventQueue<T>::merge(QF_Dispatcher &dispatcher)
+{
+    const unsigned int drained = active.load(std::memory_order_relaxed);
+    active.store(drained ^ 1U, std::memory_order_seq_cst);
+
+    while(busy.load(std::memory_order_seq_cst)) {
+        std::this_thread::yield();
+    }
+
+    for(const auto &event : buffers[drained]) {
+        dispatcher.enqueue(event);
+    }
+
+    buffers[drained].clear();
+}
+
+template<typename T>
+inline ThreadEventHandle<T>::~ThreadEventHandle(void)
+{
+    if(queue) {
+        events::detach(queue);
+    }
+}
+
+template<typename T>
+inline void events::enqueue(const T &event)
+{
+    if(events::is_main_thread()) {
+        globals::dispatcher.enqueue(event);
+        return;
+    }
+
+    auto &handle = get_thread_event_handle<T>();
+
+    if(handle.queue == nullptr) {
+        handle.queue = new ThreadEventQueue<T>();
+        events::attach(handle.queue);
+    }
+
+    handle.queue->push(event);
+}
+
+#endif /* SHARED_EVENTS_HH */
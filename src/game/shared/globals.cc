@@ -5,8 +5,9 @@ float globals::fixed_frametime;
 float globals::fixed_frametime_avg;
 std::uint64_t globals::fixed_frametime_us;
 std::size_t globals::fixed_framecount;
+float globals::fixed_alpha;
 
 std::uint64_t globals::curtime;
 
-entt::dispatcher globals::dispatcher;
-entt::registry globals::registry;
+QF_Dispatcher globals::dispatcher;
+QF_Registry globals::registry;
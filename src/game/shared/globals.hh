@@ -2,12 +2,27 @@
 #define SHARED_GLOBALS_HH 1
 #pragma once
 
+#include "core/memtrack.hh"
+
+// The registry and the dispatcher account everything
+// they allocate under MEMTAG_REGISTRY no matter which
+// subsystem or thread happens to be touching them
+using QF_Registry = entt::basic_registry<entt::entity, TaggedAllocator<entt::entity, MEMTAG_REGISTRY>>;
+using QF_Dispatcher = entt::basic_dispatcher<TaggedAllocator<void, MEMTAG_REGISTRY>>;
+
 namespace globals
 {
 extern float fixed_frametime;
 extern float fixed_frametime_avg;
 extern std::uint64_t fixed_frametime_us;
 extern std::size_t fixed_framecount;
+
+/**
+ * How far the current frame is between the last
+ * fixed tick and the next one, within [0, 1);
+ * rendering blends fixed-tick state with it
+ */
+extern float fixed_alpha;
 } // namespace globals
 
 namespace globals
@@ -17,8 +32,8 @@ extern std::uint64_t curtime;
 
 namespace globals
 {
-extern entt::dispatcher dispatcher;
-extern entt::registry registry;
+extern QF_Dispatcher dispatcher;
+extern QF_Registry registry;
 } // namespace globals
 
 #endif /* SHARED_GLOBALS_HH */
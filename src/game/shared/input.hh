@@ -2,6 +2,8 @@
 #define SHARED_INPUT_HH 1
 #pragma once
 
+#include "core/serial.hh"
+
 using IN_Bits = std::uint16_t;
 constexpr static IN_Bits IN_FORWARD = 0x0001; // Default: W; move forward
 constexpr static IN_Bits IN_BACK    = 0x0002; // Default: S; move backwards
@@ -20,4 +22,9 @@ struct ClientCommand final {
     IN_Bits keys;
 };
 
+template<>
+struct serial::Describe<ClientCommand> final {
+    using fields = serial::Fields<&ClientCommand::wishdir, &ClientCommand::angles, &ClientCommand::keys>;
+};
+
 #endif /* SHARED_INPUT_HH */
@@ -0,0 +1,128 @@
+#include "shared/precompiled.hh"
+#include "shared/systems.hh"
+
+#include "core/jobs.hh"
+#include "core/profiler.hh"
+
+#include "shared/globals.hh"
+
+struct SystemNode final {
+    const char *name;
+    QF_SystemFunction function;
+    std::vector<entt::id_type> reads;
+    std::vector<entt::id_type> writes;
+    bool exclusive;
+
+    // Systems registered later that conflict with this one
+    std::vector<SystemNode *> dependents;
+    std::size_t num_dependencies;
+    std::atomic<std::size_t> pending;
+};
+
+static std::deque<SystemNode> nodes;
+static bool graph_dirty = false;
+static JobCounter run_counter;
+
+static bool contains(const std::vector<entt::id_type> &list, entt::id_type id)
+{
+    return std::find(list.cbegin(), list.cend(), id) != list.cend();
+}
+
+static bool is_conflicting(const SystemNode &a, const SystemNode &b)
+{
+    if(a.exclusive || b.exclusive)
+        return true;
+
+    for(auto id : a.writes) {
+        if(contains(b.writes, id) || contains(b.reads, id)) {
+            return true;
+        }
+    }
+
+    for(auto id : a.reads) {
+        if(contains(b.writes, id)) {
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// The graph only changes when systems are added,
+// so it's rebuilt lazily instead of every tick
+static void build_graph(void)
+{
+    for(auto &node : nodes) {
+        node.dependents.clear();
+        node.num_dependencies = 0;
+    }
+
+    for(std::size_t i = 0; i < nodes.size(); ++i) {
+        for(std::size_t j = i + 1; j < nodes.size(); ++j) {
+            if(is_conflicting(nodes[i], nodes[j])) {
+                nodes[i].dependents.push_back(&nodes[j]);
+                nodes[j].num_dependencies += 1;
+            }
+        }
+    }
+
+    graph_dirty = false;
+}
+
+static void run_node(void *data, std::size_t)
+{
+    auto node = static_cast<SystemNode *>(data);
+
+    {
+        QF_profile_zone(node->name);
+        node->function(globals::registry);
+    }
+
+    // Dependents are queued before this job's counter
+    // decrement so the run can't look finished early
+    for(auto dependent : node->dependents) {
+        if(dependent->pending.fetch_sub(1, std::memory_order_acq_rel) == 1) {
+            jobs::submit(&run_node, dependent, &run_counter);
+        }
+    }
+}
+
+void systems::add(const char *name, QF_SystemFunction function, const std::vector<entt::id_type> &reads, const std::vector<entt::id_type> &writes)
+{
+    auto &node = nodes.emplace_back();
+    node.name = name;
+    node.function = function;
+    node.reads = reads;
+    node.writes = writes;
+    node.exclusive = contains(writes, entt::type_hash<entt::entity>::value());
+    node.num_dependencies = 0;
+    node.pending.store(0, std::memory_order_relaxed);
+
+    graph_dirty = true;
+}
+
+void systems::deinit(void)
+{
+    nodes.clear();
+    graph_dirty = false;
+}
+
+void systems::run(void)
+{
+    QF_profile_zone("systems::run");
+
+    if(graph_dirty)
+        build_graph();
+
+    for(auto &node : nodes) {
+        node.pending.store(node.num_dependencies, std::memory_order_relaxed);
+    }
+
+    for(auto &node : nodes) {
+        if(node.num_dependencies == 0) {
+            jobs::submit(&run_node, &node, &run_counter);
+        }
+    }
+
+    jobs::wait(run_counter);
+}
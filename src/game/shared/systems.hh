@@ -0,0 +1,141 @@
+#ifndef SHARED_SYSTEMS_HH
+#define SHARED_SYSTEMS_HH 1
+#pragma once
+
+#include "core/constexpr.hh"
+#include "core/jobs.hh"
+
+#include "shared/globals.hh"
+
+/**
+ * A system entry point
+ * @param registry The registry to work on
+ */
+using QF_SystemFunction = void(*)(QF_Registry &registry);
+
+/**
+ * Components a system reads; systems that only
+ * read the same components can run concurrently
+ */
+template<typename... T>
+struct SystemReads final {};
+
+/**
+ * Components a system writes; systems that create
+ * or destroy entities or add and remove components
+ * must also list entt::entity, which makes them run
+ * exclusively from every other system
+ */
+template<typename... T>
+struct SystemWrites final {};
+
+// Entities handed to a single job by systems::parallel_each
+constexpr static std::size_t SYSTEM_CHUNK_SIZE = 4096;
+
+namespace systems
+{
+/**
+ * Registers a system; systems run in registration order
+ * unless their component accesses don't conflict, in which
+ * case they may run concurrently on the job system
+ * @param name System name, must be a string literal
+ * @param function System entry point
+ */
+template<typename... R, typename... W>
+void add(const char *name, QF_SystemFunction function, SystemReads<R...> reads, SystemWrites<W...> writes);
+
+/**
+ * Registers a system with its component
+ * accesses given as entt::type_hash values
+ * @note Prefer the templated overload; it also
+ * creates the component storage up-front
+ */
+void add(const char *name, QF_SystemFunction function, const std::vector<entt::id_type> &reads, const std::vector<entt::id_type> &writes);
+
+/**
+ * Unregisters all systems
+ */
+void deinit(void);
+
+/**
+ * Runs every system once on globals::registry;
+ * returns after all of them have finished
+ * @note Should be called from the main thread
+ */
+void run(void);
+} // namespace systems
+
+namespace systems
+{
+/**
+ * Calls a function for every entity in a view, split
+ * into chunks that run concurrently on the job system
+ * @param view A view over components the calling system declared
+ * @param function Called as function(entt::entity) from any thread
+ * @param chunk_size Maximum amount of entities per job
+ */
+template<typename View, typename Function>
+void parallel_each(const View &view, const Function &function, std::size_t chunk_size = SYSTEM_CHUNK_SIZE);
+} // namespace systems
+
+template<typename View, typename Function>
+struct SystemChunks final {
+    const View *view;
+    const Function *function;
+    const entt::entity *entities;
+    std::size_t size;
+    std::size_t chunk_size;
+};
+
+template<typename View, typename Function>
+static inline void run_system_chunk(void *data, std::size_t index)
+{
+    auto chunks = static_cast<const SystemChunks<View, Function> *>(data);
+    const std::size_t begin = index * chunks->chunk_size;
+    const std::size_t end = std::min(begin + chunks->chunk_size, chunks->size);
+
+    // The leading storage may hold entities
+    // that are missing some other component
+    for(std::size_t i = begin; i < end; ++i) {
+        const entt::entity entity = chunks->entities[i];
+
+        if(chunks->view->contains(entity)) {
+            (*chunks->function)(entity);
+        }
+    }
+}
+
+template<typename... R, typename... W>
+inline void systems::add(const char *name, QF_SystemFunction function, SystemReads<R...>, SystemWrites<W...>)
+{
+    // Creating storage from worker threads would
+    // race on the registry's pool map; do it now
+    (globals::registry.storage<R>(), ...);
+    (globals::registry.storage<W>(), ...);
+
+    systems::add(name, function, { entt::type_hash<R>::value()... }, { entt::type_hash<W>::value()... });
+}
+
+template<typename View, typename Function>
+inline void systems::parallel_each(const View &view, const Function &function, std::size_t chunk_size)
+{
+    const auto leading = view.handle();
+
+    if(leading == nullptr)
+        return;
+
+    SystemChunks<View, Function> chunks;
+    chunks.view = &view;
+    chunks.function = &function;
+    chunks.entities = leading->data();
+    chunks.size = leading->size();
+    chunks.chunk_size = cxpr::max<std::size_t>(chunk_size, 1);
+
+    const std::size_t num_chunks = (chunks.size + chunks.chunk_size - 1) / chunks.chunk_size;
+
+    JobCounter counter;
+    jobs::submit_batch(&run_system_chunk<View, Function>, &chunks, num_chunks, &counter);
+    jobs::wait(counter);
+}
+
+#endif /* SHARED_SYSTEMS_HH */
@@ -0,0 +1,77 @@
+#include "core/precompiled.hh"
+
+#include "core/arena.hh"
+#include "core/config.hh"
+#include "core/memtrack.hh"
+#include "core/profiler.hh"
+#include "core/rwpool.hh"
+#include "core/strtools.hh"
+
+// Frames run before the check starts; containers
+// that are reused every frame reach their final size
+constexpr static std::size_t NUM_WARMUP_FRAMES = 4;
+constexpr static std::size_t NUM_FRAMES = 200;
+
+// Per-frame work that is expected to stay off the heap
+static void run_frame(std::size_t frame)
+{
+    QF_profile_zone("run_frame");
+
+    FrameVector<std::uint64_t> values;
+
+    for(std::size_t i = 0; i < 256; ++i) {
+        QF_profile_zone("value");
+        values.push_back(frame * i);
+    }
+
+    const auto tokens = strtools::split_view("client.tick_rate = 60 # comment", " ");
+    QF_profile_counter("tokens", tokens.size());
+    QF_profile_counter("values", values.size());
+}
+
+// Mirrors the tail of the client's main loop
+static void end_frame(void)
+{
+    config::update();
+    rwpool::update_frame();
+    memtrack::update_frame();
+    profiler::end_frame();
+    frame_arena::next_frame();
+
+    QF_profile_counter("memtrack.frame_allocations", memtrack::frame_allocations());
+    QF_profile_counter("frame_arena.used_bytes", frame_arena::get_stats().used_bytes);
+}
+
+int main(void)
+{
+    memtrack::init();
+    frame_arena::init();
+    profiler::init();
+    profiler::set_thread_name("main");
+
+    std::size_t num_failed = 0;
+
+    for(std::size_t frame = 0; frame < NUM_WARMUP_FRAMES + NUM_FRAMES; ++frame) {
+        run_frame(frame);
+        end_frame();
+
+        if((frame < NUM_WARMUP_FRAMES) || (memtrack::frame_allocations() == 0))
+            continue;
+
+        for(unsigned int i = 0; i < MEMTAG_COUNT; ++i) {
+            const auto tag = static_cast<QF_MemoryTag>(i);
+            const auto stats = memtrack::get_stats(tag);
+
+            if(stats.frame_allocations) {
+                std::printf("frame %zu: %s: %zu allocations\n", frame, memtrack::get_tag_name(tag), stats.frame_allocations);
+            }
+        }
+
+        num_failed += 1;
+    }
+
+    profiler::deinit();
+
+    std::printf("steady-state frames allocate nothing: %s\n", num_failed ? "FAILED" : "ok");
+    return num_failed ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,64 @@
+#include "core/precompiled.hh"
+#include "core/queue.hh"
+
+constexpr static std::uint64_t NUM_ELEMENTS = 10000000;
+
+// Producers and consumers busy-spin on full and empty
+// queues; results only make sense with a core per thread
+template<typename Queue>
+static double run(Queue &queue, unsigned int num_producers, unsigned int num_consumers)
+{
+    const std::uint64_t per_producer = NUM_ELEMENTS / num_producers;
+    const std::uint64_t total = per_producer * num_producers;
+    std::atomic<std::uint64_t> num_popped = 0;
+    std::vector<std::thread> threads;
+
+    const auto start = std::chrono::steady_clock::now();
+
+    for(unsigned int i = 0U; i < num_producers; ++i) {
+        threads.emplace_back([&](void) {
+            for(std::uint64_t value = 0; value < per_producer; ++value) {
+                while(!queue.try_push(value)) {
+                    std::this_thread::yield();
+                }
+            }
+        });
+    }
+
+    for(unsigned int i = 0U; i < num_consumers; ++i) {
+        threads.emplace_back([&](void) {
+            std::uint64_t value;
+
+            while(num_popped.load(std::memory_order_relaxed) < total) {
+                if(queue.try_pop(value))
+                    num_popped.fetch_add(1, std::memory_order_relaxed);
+                else std::this_thread::yield();
+            }
+        });
+    }
+
+    for(auto &thread : threads)
+        thread.join();
+
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+    return static_cast<double>(total) / elapsed.count() / 1.0e6;
+}
+
+int main(int argc, char **argv)
+{
+    const std::size_t capacity = (argc > 1) ? std::strtoull(argv[1], nullptr, 10) : 1024;
+
+    std::printf("capacity %zu, %u hardware threads\n", capacity, std::thread::hardware_concurrency());
+
+    {
+        SPSCQueue<std::uint64_t> queue(capacity);
+        std::printf("spsc 1x1: %.2f Mops/s\n", run(queue, 1U, 1U));
+    }
+
+    for(auto threads : { 1U, 2U, 4U }) {
+        MPMCQueue<std::uint64_t> queue(capacity);
+        std::printf("mpmc %ux%u: %.2f Mops/s\n", threads, threads, run(queue, threads, threads));
+    }
+
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,180 @@
+#include "core/precompiled.hh"
+#include "core/queue.hh"
+
+// Elements pushed by every producer; kept
+// small enough to finish quickly under TSan
+constexpr static std::uint64_t NUM_ELEMENTS = 200000;
+
+static bool check(bool condition, const char *what)
+{
+    std::printf("%s: %s\n", what, condition ? "ok" : "FAILED");
+    return condition;
+}
+
+// Pops a single value, sleeping on the notifier while
+// the queue is empty; pairs with push_notify below
+template<typename Queue>
+static void pop_wait(Queue &queue, ThreadNotifier &notifier, std::uint64_t &value)
+{
+    while(!queue.try_pop(value)) {
+        auto key = notifier.prepare_wait();
+
+        if(queue.try_pop(value)) {
+            notifier.cancel_wait();
+            return;
+        }
+
+        notifier.commit_wait(key);
+    }
+}
+
+template<typename Queue>
+static void push_wait(Queue &queue, ThreadNotifier &notifier, std::uint64_t value)
+{
+    while(!queue.try_push(value)) {
+        auto key = notifier.prepare_wait();
+
+        if(queue.try_push(value)) {
+            notifier.cancel_wait();
+            return;
+        }
+
+        notifier.commit_wait(key);
+    }
+}
+
+// Both sides block on notifiers; the producer
+// stalls now and then so the consumer goes to sleep
+static bool stress_spsc(void)
+{
+    SPSCQueue<std::uint64_t> queue(64);
+    ThreadNotifier not_empty;
+    ThreadNotifier not_full;
+    bool in_order = true;
+
+    std::thread consumer([&](void) {
+        for(std::uint64_t i = 0; i < NUM_ELEMENTS; ++i) {
+            std::uint64_t value;
+            pop_wait(queue, not_empty, value);
+            in_order = in_order && (value == i);
+            not_full.notify_one();
+        }
+    });
+
+    for(std::uint64_t i = 0; i < NUM_ELEMENTS; ++i) {
+        push_wait(queue, not_full, i);
+        not_empty.notify_one();
+
+        if(i % 10000 == 0) {
+            std::this_thread::sleep_for(std::chrono::microseconds(200));
+        }
+    }
+
+    consumer.join();
+
+    return check(in_order && (queue.size_approx() == 0), "spsc");
+}
+
+static bool stress_mpmc(unsigned int num_producers, unsigned int num_consumers)
+{
+    MPMCQueue<std::uint64_t> queue(128);
+    ThreadNotifier not_empty;
+    ThreadNotifier not_full;
+
+    const std::uint64_t total = NUM_ELEMENTS * num_producers;
+    std::atomic<std::uint64_t> num_popped = 0;
+    std::atomic<std::uint64_t> sum = 0;
+    std::vector<std::thread> threads;
+
+    for(unsigned int i = 0; i < num_producers; ++i) {
+        threads.emplace_back([&](void) {
+            for(std::uint64_t value = 1; value <= NUM_ELEMENTS; ++value) {
+                push_wait(queue, not_full, value);
+                not_empty.notify_one();
+            }
+        });
+    }
+
+    // Every consumer pops its share so that
+    // nobody is left asleep on an empty queue
+    for(unsigned int i = 0; i < num_consumers; ++i) {
+        const std::uint64_t share = (total / num_consumers) + ((i == 0) ? (total % num_consumers) : 0);
+
+        threads.emplace_back([&, share](void) {
+            for(std::uint64_t j = 0; j < share; ++j) {
+                std::uint64_t value;
+                pop_wait(queue, not_empty, value);
+                sum.fetch_add(value, std::memory_order_relaxed);
+                num_popped.fetch_add(1, std::memory_order_relaxed);
+                not_full.notify_all();
+            }
+        });
+    }
+
+    for(auto &thread : threads)
+        thread.join();
+
+    char what[64];
+    std::snprintf(what, sizeof(what), "mpmc %ux%u", num_producers, num_consumers);
+
+    const std::uint64_t expected = num_producers * (NUM_ELEMENTS * (NUM_ELEMENTS + 1) / 2);
+    return check((num_popped.load() == total) && (sum.load() == expected), what);
+}
+
+// Many sleepers woken at once; none of them may be lost
+static bool stress_notify_all(void)
+{
+    ThreadNotifier notifier;
+    std::atomic<unsigned int> round = 0U;
+    std::atomic<unsigned int> num_woken = 0U;
+    std::vector<std::thread> threads;
+
+    constexpr unsigned int NUM_THREADS = 8U;
+    constexpr unsigned int NUM_ROUNDS = 500U;
+
+    for(unsigned int i = 0U; i < NUM_THREADS; ++i) {
+        threads.emplace_back([&](void) {
+            for(unsigned int seen = 0U; seen < NUM_ROUNDS;) {
+                while(round.load(std::memory_order_acquire) == seen) {
+                    auto key = notifier.prepare_wait();
+
+                    if(round.load(std::memory_order_acquire) != seen) {
+                        notifier.cancel_wait();
+                        break;
+                    }
+
+                    notifier.commit_wait(key);
+                }
+
+                seen += 1U;
+                num_woken.fetch_add(1U, std::memory_order_relaxed);
+            }
+        });
+    }
+
+    for(unsigned int i = 0U; i < NUM_ROUNDS; ++i) {
+        // Wait for every thread to finish the previous round
+        while(num_woken.load(std::memory_order_relaxed) < i * NUM_THREADS)
+            std::this_thread::yield();
+        round.fetch_add(1U, std::memory_order_release);
+        notifier.notify_all();
+    }
+
+    for(auto &thread : threads)
+        thread.join();
+
+    return check(num_woken.load() == NUM_THREADS * NUM_ROUNDS, "notify_all");
+}
+
+int main(void)
+{
+    bool success = true;
+
+    success = stress_spsc() && success;
+    success = stress_mpmc(1U, 1U) && success;
+    success = stress_mpmc(3U, 2U) && success;
+    success = stress_mpmc(2U, 4U) && success;
+    success = stress_notify_all() && success;
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}
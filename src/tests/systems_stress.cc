@@ -0,0 +1,241 @@
+#include "shared/precompiled.hh"
+#include "shared/systems.hh"
+
+#include "core/cmdline.hh"
+#include "core/jobs.hh"
+
+#include "shared/globals.hh"
+
+// Kept small enough to finish quickly under TSan;
+// the chunk size is lowered so parallel_each splits
+constexpr static std::size_t NUM_ENTITIES = 20000;
+constexpr static std::uint64_t NUM_TICKS = 100;
+constexpr static std::size_t CHUNK_SIZE = 512;
+
+struct Position final {
+    std::uint64_t value;
+};
+
+struct Velocity final {
+    std::uint64_t value;
+};
+
+struct Health final {
+    std::uint64_t value;
+};
+
+// Systems mark the components they touch while they run;
+// finding a conflicting access already in progress means
+// the scheduler let two conflicting systems overlap
+struct AccessTracker final {
+    std::atomic<int> readers;
+    std::atomic<int> writers;
+};
+
+static AccessTracker position_access;
+static AccessTracker velocity_access;
+static AccessTracker health_access;
+static std::atomic<bool> exclusive_running = false;
+static std::atomic<int> num_running = 0;
+static std::atomic<int> max_running = 0;
+static std::atomic<std::size_t> num_overlaps = 0;
+static std::atomic<std::size_t> num_mismatches = 0;
+
+// Written by the main thread between runs
+static std::uint64_t current_tick = 0;
+
+static void begin_read(AccessTracker &access)
+{
+    access.readers.fetch_add(1);
+
+    if(access.writers.load())
+        num_overlaps.fetch_add(1);
+}
+
+static void end_read(AccessTracker &access)
+{
+    access.readers.fetch_sub(1);
+}
+
+static void begin_write(AccessTracker &access)
+{
+    if(access.writers.fetch_add(1) || access.readers.load())
+        num_overlaps.fetch_add(1);
+}
+
+static void end_write(AccessTracker &access)
+{
+    access.writers.fetch_sub(1);
+}
+
+static void begin_system(void)
+{
+    const int running = 1 + num_running.fetch_add(1);
+
+    if(exclusive_running.load())
+        num_overlaps.fetch_add(1);
+
+    int previous = max_running.load();
+
+    while(previous < running) {
+        if(max_running.compare_exchange_weak(previous, running)) {
+            break;
+        }
+    }
+
+    // Widens the window for an overlap to show up
+    std::this_thread::sleep_for(std::chrono::microseconds(50));
+}
+
+static void end_system(void)
+{
+    num_running.fetch_sub(1);
+}
+
+static void integrate(QF_Registry &registry)
+{
+    begin_system();
+    begin_read(velocity_access);
+    begin_write(position_access);
+
+    auto view = registry.view<Position, const Velocity>();
+
+    systems::parallel_each(view, [&view](entt::entity entity) {
+        view.get<Position>(entity).value += view.get<const Velocity>(entity).value;
+    }, CHUNK_SIZE);
+
+    end_write(position_access);
+    end_read(velocity_access);
+    end_system();
+}
+
+// Registered after integrate and reads what it
+// writes, so it must see this tick's positions
+static void check_positions(QF_Registry &registry)
+{
+    begin_system();
+    begin_read(position_access);
+    begin_read(velocity_access);
+
+    for(auto [entity, position] : registry.view<const Position>().each()) {
+        const Velocity *velocity = registry.try_get<Velocity>(entity);
+        const std::uint64_t expected = velocity ? (velocity->value * current_tick) : 0;
+
+        if(position.value != expected) {
+            num_mismatches.fetch_add(1);
+        }
+    }
+
+    end_read(velocity_access);
+    end_read(position_access);
+    end_system();
+}
+
+// Doesn't conflict with anything above and may run alongside it
+static void regenerate(QF_Registry &registry)
+{
+    begin_system();
+    begin_write(health_access);
+
+    auto view = registry.view<Health>();
+
+    systems::parallel_each(view, [&view](entt::entity entity) {
+        view.get<Health>(entity).value += 1;
+    }, CHUNK_SIZE);
+
+    end_write(health_access);
+    end_system();
+}
+
+static void observe_velocity(QF_Registry &registry)
+{
+    begin_system();
+    begin_read(velocity_access);
+
+    std::uint64_t sum = 0;
+
+    for(auto [entity, velocity] : registry.view<const Velocity>().each()) {
+        sum += velocity.value;
+    }
+
+    if(sum != (NUM_ENTITIES / 2) * (NUM_ENTITIES / 2 + 1) / 2) {
+        num_mismatches.fetch_add(1);
+    }
+
+    end_read(velocity_access);
+    end_system();
+}
+
+// Creates entities so it must run alone; registered
+// after regenerate so it runs after it within a tick
+static void spawn(QF_Registry &registry)
+{
+    exclusive_running.store(true);
+
+    if(num_running.fetch_add(1))
+        num_overlaps.fetch_add(1);
+
+    // Healed once per remaining tick, a newly
+    // spawned entity ends up at NUM_TICKS as well
+    registry.emplace<Health>(registry.create(), current_tick);
+
+    num_running.fetch_sub(1);
+    exclusive_running.store(false);
+}
+
+static bool check(bool condition, const char *what)
+{
+    std::printf("%s: %s\n", what, condition ? "ok" : "FAILED");
+    return condition;
+}
+
+int main(int argc, char **argv)
+{
+    cmdline::init(argc, argv);
+
+    jobs::init();
+    jobs::init_late();
+
+    for(std::size_t i = 0; i < NUM_ENTITIES; ++i) {
+        const entt::entity entity = globals::registry.create();
+        globals::registry.emplace<Position>(entity, UINT64_C(0));
+        globals::registry.emplace<Health>(entity, UINT64_C(0));
+
+        // Only every other entity moves so the leading
+        // storage holds entities that parallel_each skips
+        if(i % 2 == 0) {
+            globals::registry.emplace<Velocity>(entity, static_cast<std::uint64_t>(i / 2 + 1));
+        }
+    }
+
+    systems::add("integrate", &integrate, SystemReads<Velocity>(), SystemWrites<Position>());
+    systems::add("check_positions", &check_positions, SystemReads<Position, Velocity>(), SystemWrites<>());
+    systems::add("regenerate", &regenerate, SystemReads<>(), SystemWrites<Health>());
+    systems::add("observe_velocity", &observe_velocity, SystemReads<Velocity>(), SystemWrites<>());
+    systems::add("spawn", &spawn, SystemReads<>(), SystemWrites<entt::entity, Health>());
+
+    for(current_tick = 1; current_tick <= NUM_TICKS; ++current_tick) {
+        systems::run();
+    }
+
+    std::size_t num_unhealed = 0;
+
+    for(auto [entity, health] : globals::registry.view<const Health>().each()) {
+        if(health.value != NUM_TICKS) {
+            num_unhealed += 1;
+        }
+    }
+
+    std::printf("%d systems ran concurrently at most with %u workers\n", max_running.load(), jobs::num_workers());
+
+    bool success = true;
+
+    success = check(num_overlaps.load() == 0, "conflicting systems never overlap") && success;
+    success = check(num_mismatches.load() == 0, "dependent systems run in order") && success;
+    success = check((num_unhealed == 0) && (globals::registry.storage<Health>().size() == NUM_ENTITIES + NUM_TICKS), "exclusive systems") && success;
+
+    systems::deinit();
+    jobs::deinit();
+
+    return success ? EXIT_SUCCESS : EXIT_FAILURE;
+}